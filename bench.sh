@@ -0,0 +1,28 @@
+#!/bin/sh
+# Builds and runs the microbenchmarks on Linux (needs a C++20 compiler and the X11/GL dev packages for raylib).
+#   ./bench.sh                   compare against source/bench_baseline.txt, exit 1 on a >10% regression
+#   ./bench.sh --write-baseline source/bench_baseline.txt
+set -e
+cd "$(dirname "$0")"
+
+compilerFlags="-std=c++20 -O2 -mavx2 -mfma -ffast-math -g"
+mkdir -p build/linux
+
+# The lib bakes in external/raylib/config.h; the copy kept next to it tells when that changed
+if [ ! -f build/linux/libraylib.a ] || ! cmp -s external/raylib/config.h build/linux/raylib_config.h; then
+	echo "building raylib"
+	for f in rcore raudio rglfw rmodels rshapes rtext rtextures utils; do
+		cc -w -c -O2 -DPLATFORM_DESKTOP -DGRAPHICS_API_OPENGL_33 -D_GNU_SOURCE -Iexternal/raylib/external/glfw/include \
+			external/raylib/$f.c -o build/linux/$f.o
+	done
+	ar rcs build/linux/libraylib.a build/linux/*.o
+	rm -f build/linux/*.o
+	cp external/raylib/config.h build/linux/raylib_config.h
+fi
+
+c++ $compilerFlags -Wall -I external/raylib source/Bench.cpp build/linux/libraylib.a -lGL -lm -lpthread -ldl -lrt -lX11 -o build/linux/Bench
+
+if [ $# -eq 0 ]; then
+	exec build/linux/Bench --baseline source/bench_baseline.txt
+fi
+exec build/linux/Bench "$@"
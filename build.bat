@@ -26,18 +26,36 @@ if "%~1"=="-Release" (
 	set compilerFlags=%compilerFlags% /O2 /MT 
 	set rayname=raylib
 )
+if "%~1"=="-Bench" (
+	echo [[ release build + microbenchmarks ]]
+	set compilerFlags=%compilerFlags% /O2 /MT 
+	set rayname=raylib
+)
 
 IF NOT EXIST .\build mkdir .\build
 pushd .\build
 del *.pdb > NUL 2> NUL
 
-IF NOT EXIST %rayname%.lib (
+REM The lib bakes in external/raylib/config.h; the copy kept next to it tells when that changed
+set buildRaylib=0
+IF NOT EXIST %rayname%.lib set buildRaylib=1
+fc /b ..\external\raylib\config.h %rayname%.config.h > NUL 2> NUL || set buildRaylib=1
+IF "%buildRaylib%"=="1" (
 echo building raylib
 REM Had to go to platforms directory and change path for GLFW include headers
 cl.exe /w /c /D PLATFORM_DESKTOP /D GRAPHICS_API_OPENGL_33 %compilerFlags% ../external/raylib/*.c
 lib /OUT:%rayname%.lib rcore.obj raudio.obj rglfw.obj rmodels.obj rshapes.obj rtext.obj rtextures.obj utils.obj
 del /Q *.obj
+copy /Y ..\external\raylib\config.h %rayname%.config.h > NUL
 )
 
 cl.exe %compilerFlags% %warnings% %includes% ../source/Main.cpp /link %linkerFlags% %rayname%.lib %linkerLibs%
+cl.exe %compilerFlags% %warnings% ../source/MetricsReader.cpp /link /OUT:MetricsReader.exe
+cl.exe %compilerFlags% %warnings% %includes% ../source/BatchRun.cpp /link /OUT:BatchRun.exe %rayname%.lib %linkerLibs%
+cl.exe %compilerFlags% %warnings% %includes% ../source/SoftRender.cpp /link /OUT:SoftRender.exe %rayname%.lib %linkerLibs%
+
+if "%~1"=="-Bench" (
+cl.exe %compilerFlags% %warnings% %includes% ../source/Bench.cpp /link /OUT:Bench.exe %rayname%.lib %linkerLibs%
+Bench.exe --baseline ../source/bench_baseline.txt
+)
 popd
\ No newline at end of file
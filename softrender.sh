@@ -0,0 +1,31 @@
+#!/bin/sh
+# Builds SoftRender on Linux and checks the CPU rasterizer's last frame against the reference image.
+#   ./softrender.sh                      compare against source/softrender_reference.png, exit 1 on any pixel off
+#   ./softrender.sh --write-reference    regenerate it after an intended change to the draw path
+set -e
+cd "$(dirname "$0")"
+
+# As bench.sh, but without fused multiply-adds so the image does not depend on where the compiler fuses them
+compilerFlags="-std=c++20 -O2 -mavx2 -mfma -ffast-math -ffp-contract=off -g"
+mkdir -p build/linux
+
+# The lib bakes in external/raylib/config.h; the copy kept next to it tells when that changed
+if [ ! -f build/linux/libraylib.a ] || ! cmp -s external/raylib/config.h build/linux/raylib_config.h; then
+	echo "building raylib"
+	for f in rcore raudio rglfw rmodels rshapes rtext rtextures utils; do
+		cc -w -c -O2 -DPLATFORM_DESKTOP -DGRAPHICS_API_OPENGL_33 -D_GNU_SOURCE -Iexternal/raylib/external/glfw/include \
+			external/raylib/$f.c -o build/linux/$f.o
+	done
+	ar rcs build/linux/libraylib.a build/linux/*.o
+	rm -f build/linux/*.o
+	cp external/raylib/config.h build/linux/raylib_config.h
+fi
+
+c++ $compilerFlags -Wall -I external/raylib source/SoftRender.cpp build/linux/libraylib.a -lGL -lm -lpthread -ldl -lrt -lX11 -o build/linux/SoftRender
+
+# The sprites are next to the game
+cd build
+if [ "$1" = "--write-reference" ]; then
+	exec linux/SoftRender --png ../source/softrender_reference.png
+fi
+exec linux/SoftRender --golden ../source/softrender_reference.png
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include <raylib.h>
+#include <raymath.h>
+#include <rlgl.h>
+
+// --- SDF ASTEROID OUTLINES ---
+// Draws heart/star/flower asteroids as one instanced quad each. The fragment shader
+// evaluates a distance approximation to the same curves DrawHeart/DrawStar/DrawFlower
+// build on the CPU and turns it into an anti-aliased outline.
+
+struct SdfInstance {
+	float x, y;
+	float radius;
+	float rotation; // degrees, same as TransformA::rotation
+	float shape;
+	unsigned char r, g, b, a;
+};
+
+class AsteroidSdfRenderer {
+public:
+	enum Shape { HEART = 0, STAR = 1, FLOWER = 2 };
+
+	bool Load() {
+		shaderId = rlLoadShaderCode(VS_CODE, FS_CODE);
+		if (shaderId == 0 || shaderId == rlGetShaderIdDefault()) {
+			shaderId = 0;
+			return false;
+		}
+		mvpLoc = rlGetLocationUniform(shaderId, "mvp");
+
+		// Two triangles spanning [-1, 1], expanded per instance in the vertex shader.
+		// Wound counter-clockwise on screen (y down) so rlgl's back-face culling keeps them.
+		static const float quad[12] = { -1, -1, -1, 1, 1, 1, -1, -1, 1, 1, 1, -1 };
+		vao = rlLoadVertexArray();
+		rlEnableVertexArray(vao);
+		quadVbo = rlLoadVertexBuffer(quad, sizeof(quad), false);
+		rlSetVertexAttribute(ATTR_CORNER, 2, RL_FLOAT, false, 0, 0);
+		rlEnableVertexAttribute(ATTR_CORNER);
+		CreateInstanceBuffer(INITIAL_CAPACITY);
+		rlDisableVertexArray();
+		return true;
+	}
+
+	void Unload() {
+		if (!IsReady()) return;
+		rlUnloadVertexBuffer(instanceVbo);
+		rlUnloadVertexBuffer(quadVbo);
+		rlUnloadVertexArray(vao);
+		rlUnloadShaderProgram(shaderId);
+		shaderId = 0;
+	}
+
+	bool IsReady() const {
+		return shaderId != 0;
+	}
+
+	void Submit(Vector2 pos, float radius, float rotation, Shape shape, Color color) {
+		instances.push_back({ pos.x, pos.y, radius, rotation, static_cast<float>(shape), color.r, color.g, color.b, color.a });
+	}
+
+	// Draws everything submitted since the last flush in one instanced draw call
+	void Flush() {
+		if (instances.empty()) return;
+		if (!IsReady()) {
+			instances.clear();
+			return;
+		}
+
+		rlDrawRenderBatchActive(); // keep ordering with everything drawn so far
+		rlEnableShader(shaderId);
+		Matrix mvp = MatrixMultiply(MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview()), rlGetMatrixProjection());
+		rlSetUniformMatrix(mvpLoc, mvp);
+
+		rlEnableVertexArray(vao);
+		int count = static_cast<int>(instances.size());
+		if (count > capacity) {
+			rlUnloadVertexBuffer(instanceVbo);
+			CreateInstanceBuffer(count * 2);
+		}
+		rlUpdateVertexBuffer(instanceVbo, instances.data(), count * static_cast<int>(sizeof(SdfInstance)), 0);
+		rlDrawVertexArrayInstanced(0, 6, count);
+		rlDisableVertexArray();
+		rlDisableShader();
+
+		instances.clear();
+	}
+
+	void Clear() {
+		instances.clear();
+	}
+
+	size_t Count() const {
+		return instances.size();
+	}
+
+private:
+	static constexpr unsigned int ATTR_CORNER = 0;
+	static constexpr unsigned int ATTR_XFORM = 1;
+	static constexpr unsigned int ATTR_SHAPE = 2;
+	static constexpr unsigned int ATTR_COLOR = 3;
+	static constexpr int INITIAL_CAPACITY = 256;
+
+	// Expects the VAO to be bound
+	void CreateInstanceBuffer(int cap) {
+		capacity = cap;
+		instanceVbo = rlLoadVertexBuffer(nullptr, capacity * static_cast<int>(sizeof(SdfInstance)), true);
+		const int stride = sizeof(SdfInstance);
+		rlSetVertexAttribute(ATTR_XFORM, 4, RL_FLOAT, false, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, x)));
+		rlSetVertexAttribute(ATTR_SHAPE, 1, RL_FLOAT, false, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, shape)));
+		rlSetVertexAttribute(ATTR_COLOR, 4, RL_UNSIGNED_BYTE, true, stride, reinterpret_cast<const void*>(offsetof(SdfInstance, r)));
+		for (unsigned int attr : { ATTR_XFORM, ATTR_SHAPE, ATTR_COLOR }) {
+			rlEnableVertexAttribute(attr);
+			rlSetVertexAttributeDivisor(attr, 1);
+		}
+	}
+
+	unsigned int shaderId = 0;
+	int mvpLoc = -1;
+	unsigned int vao = 0;
+	unsigned int quadVbo = 0;
+	unsigned int instanceVbo = 0;
+	int capacity = 0;
+	std::vector<SdfInstance> instances;
+
+	inline static const char* VS_CODE = R"(#version 330
+layout(location = 0) in vec2 corner;
+layout(location = 1) in vec4 instXform;  // x, y, radius, rotation (deg)
+layout(location = 2) in float instShape;
+layout(location = 3) in vec4 instColor;
+
+uniform mat4 mvp;
+
+out vec2 local;        // shape space, in units of radius
+flat out int shape;
+out vec4 color;
+
+const float EXTENT = 1.4; // flower petals reach 1.3 radius
+
+void main() {
+	vec2 q = corner * EXTENT;
+	float a = radians(instXform.w);
+	shape = int(instShape + 0.5);
+	// Hearts are built with y pointing up, the other shapes with y down
+	if (shape == 0) q.y = -q.y;
+	local = vec2(q.x * cos(a) + q.y * sin(a), -q.x * sin(a) + q.y * cos(a));
+	color = instColor;
+	gl_Position = mvp * vec4(instXform.xy + corner * EXTENT * instXform.z, 0.0, 1.0);
+}
+)";
+
+	inline static const char* FS_CODE = R"(#version 330
+in vec2 local;
+flat in int shape;
+in vec4 color;
+
+out vec4 finalColor;
+
+const float PI = 3.14159265;
+const float LINE_WIDTH = 1.5; // pixels
+
+vec2 heartPoint(float t) {
+	float s = sin(t);
+	float x = 16.0 * s * s * s;
+	float y = 13.0 * cos(t) - 5.0 * cos(2.0 * t) - 2.0 * cos(3.0 * t) - cos(4.0 * t);
+	return vec2(x, y) / 32.0;
+}
+
+// Distance to the parametric heart: coarse sampling, then two local refinements
+float sdHeart(vec2 p) {
+	const int COARSE = 32;
+	float bestT = 0.0;
+	float best = 1e9;
+	for (int i = 0; i < COARSE; ++i) {
+		float t = float(i) * 2.0 * PI / float(COARSE);
+		float d = dot(p - heartPoint(t), p - heartPoint(t));
+		if (d < best) { best = d; bestT = t; }
+	}
+	float h = PI / float(COARSE);
+	for (int pass = 0; pass < 2; ++pass) {
+		float center = bestT;
+		for (int i = -4; i <= 4; ++i) {
+			float t = center + float(i) * h * 0.25;
+			vec2 v = p - heartPoint(t);
+			float d = dot(v, v);
+			if (d < best) { best = d; bestT = t; }
+		}
+		h *= 0.25;
+	}
+	return sqrt(best);
+}
+
+// Five-pointed star, outer radius 1, inner 0.5, first tip on +x
+float sdStar(vec2 p) {
+	const float SECTOR = 2.0 * PI / 5.0;
+	float ang = mod(atan(p.y, p.x), SECTOR);
+	ang = min(ang, SECTOR - ang);
+	vec2 q = length(p) * vec2(cos(ang), sin(ang));
+	vec2 a = vec2(1.0, 0.0);
+	vec2 b = 0.5 * vec2(cos(SECTOR * 0.5), sin(SECTOR * 0.5));
+	vec2 ab = b - a;
+	float h = clamp(dot(q - a, ab) / dot(ab, ab), 0.0, 1.0);
+	float d = length(q - a - ab * h);
+	return (ab.x * (q.y - a.y) - ab.y * (q.x - a.x)) > 0.0 ? -d : d;
+}
+
+// Polar rose r = 1 + 0.3 sin(6t), first-order distance correction
+float sdFlower(vec2 p) {
+	float t = atan(p.y, p.x);
+	float r = 1.0 + 0.3 * sin(6.0 * t);
+	float dr = 1.8 * cos(6.0 * t);
+	return (length(p) - r) / sqrt(1.0 + (dr * dr) / (r * r));
+}
+
+void main() {
+	float d;
+	if (shape == 0) d = sdHeart(local);
+	else if (shape == 1) d = sdStar(local);
+	else d = sdFlower(local);
+
+	// Pixel footprint in shape units; d itself is not smooth enough for fwidth (heart is unsigned, flower has a pole)
+	float pixel = max(length(dFdx(local)), 1e-5);
+	float px = abs(d) / pixel;
+	float alpha = clamp(LINE_WIDTH * 0.5 + 0.5 - px, 0.0, 1.0);
+	if (alpha <= 0.0) discard;
+	finalColor = vec4(color.rgb, color.a * alpha);
+}
+)";
+};
@@ -0,0 +1,1025 @@
+// Headless batch runner for balancing. Pulls in the game as a unity build without its
+// main() like Bench.cpp and plays many independent games in lockstep, as fast as the
+// CPU goes: no window, no real time.
+//
+//   BatchRun [--games n] [--envs n] [--bot random|dodge] [--seconds s] [--seed n]
+//            [--spawn-min s] [--spawn-max s] [--heal n] [--nightmare n]
+//            [--sweep rule=v1,v2,...] [--parity n]
+//
+// Each environment plays games back to back until it has its share of --games; a game
+// ends when the player dies or after --seconds. --sweep splits the environments evenly
+// between the values of one rule (spawn-min, spawn-max, heal, nightmare) and reports
+// every value on its own line.
+//
+// The default bot is Bots::Random, which dies within a few minutes, so survival time
+// moves with the rules. Bots::Dodge almost never dies under the shipped rules.
+//
+// --parity n plays seeds --seed .. --seed + n - 1 with the random bot through BatchEnv
+// and through Application::Tick(), compares HP and score after every tick up to the
+// death or --seconds and exits with 1 if any game differs. It needs the game's PNGs
+// in the working directory and opens a hidden window to load them.
+
+#define _CRT_SECURE_NO_WARNINGS
+#define UNICORNS_NO_MAIN
+#include "Main.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// --- BATCH ENVIRONMENT ---
+// Application's Tick() for a game with no world population and no swarms
+// (GameRules::swarms off), minus rendering: the camera and its awake window of sectors,
+// the spawner scripts on their tick clock, exits and sleeping asteroids, shots, hearts,
+// boost and nightmare, resolved in ResolveEvents() order and drawing the same random
+// numbers in the same order. --parity checks it against the game. The differences are
+// the fixed pools: spawning also waits while the asteroid pool is full, and shots,
+// hearts or woken asteroids that do not fit are dropped. The player and heart radii are
+// those of the shipped sprites unless SetRadii() says otherwise.
+//
+// State is SoA across games: per-game values are arrays indexed by game and the entity
+// pools are [slot * games + game], so slot k of LANES consecutive games is one AVX2
+// register and the shot loop runs across games instead of across entities. Step()
+// shards the games over the JobPool in blocks of LANES.
+class BatchEnv {
+public:
+	static constexpr int LANES = 8;
+	static constexpr int MAX_ASTEROIDS = 256; // awake per game
+	static constexpr int MAX_SHOTS = 128;     // per weapon; ~120 bullets is the most in flight
+	static constexpr int MAX_HEARTS = 4;
+	static constexpr int NEAREST = 4;         // asteroids in an observation
+	static constexpr int OBS = 7 + NEAREST * 5;
+	static constexpr int MIN_BLOCKS_PER_CHUNK = 8;
+	static constexpr float PLAYER_RADIUS = 41.f; // the ship sprite at PlayerShip's 0.08 scale
+	static constexpr float HEART_RADIUS = 19.f;  // cake.png at Heart's 0.07 scale
+	static constexpr float HEART_SPEED = 100.f;
+	static constexpr float PLAYER_SPEED = 250.f;
+
+	struct Episode {
+		int game;
+		float seconds;
+		int score;
+		bool died;      // otherwise it ran out of time
+		bool nightmare;
+	};
+
+	// 'games' is rounded up to whole blocks; every game starts with the default rules
+	void Init(int games, uint64_t seed, float tickSeconds, float maxSeconds) {
+		count = (games + LANES - 1) / LANES * LANES;
+		dt = tickSeconds;
+		limit = maxSeconds;
+		size_t n = static_cast<size_t>(count);
+		px.assign(n, 0.f);
+		py.assign(n, 0.f);
+		cx.assign(n, 0.f);
+		cy.assign(n, 0.f);
+		hp.assign(n, 0);
+		score.assign(n, 0);
+		boost.assign(n, 0.f);
+		nightmare.assign(n, 0);
+		weapon.assign(n, 0);
+		boostFired.assign(n, 0);
+		spawnWaiting.assign(n, 0);
+		lastAction.assign(n, 0);
+		shotTimer.assign(n, 0.f);
+		elapsed.assign(n, 0.f);
+		simTime.assign(n, 0.0);
+		scriptTime.assign(n, 0.0);
+		asteroidTop.assign(n, 0);
+		shotTop.assign(n * WEAPON_COUNT, 0);
+		heartTop.assign(n, 0);
+		rng.assign(n, Utils::GameRandom{});
+		rules.assign(n, GameRules{});
+		scripts = std::vector<TimingWheel<uint8_t>>(n);
+		world = std::vector<SectorGrid<SleeperPtr>>(n);
+		woken = std::vector<std::vector<SleeperPtr>>(n);
+
+		ax.assign(n * MAX_ASTEROIDS, 0.f);
+		ay.assign(n * MAX_ASTEROIDS, 0.f);
+		avx.assign(n * MAX_ASTEROIDS, 0.f);
+		avy.assign(n * MAX_ASTEROIDS, 0.f);
+		ar.assign(n * MAX_ASTEROIDS, 0.f);
+		asize.assign(n * MAX_ASTEROIDS, 0);
+		aflags.assign(n * MAX_ASTEROIDS, 0);
+		aexit.assign(n * MAX_ASTEROIDS, 0);
+		sx.assign(n * MAX_SHOTS * WEAPON_COUNT, 0.f);
+		sy.assign(n * MAX_SHOTS * WEAPON_COUNT, 0.f);
+		sr.assign(n * MAX_SHOTS * WEAPON_COUNT, 0.f);
+		hx.assign(n * MAX_HEARTS, 0.f);
+		hy.assign(n * MAX_HEARTS, 0.f);
+		hflags.assign(n * MAX_HEARTS, 0);
+		hexit.assign(n * MAX_HEARTS, 0);
+
+		obs.assign(n * OBS, 0.f);
+		reward.assign(n, 0.f);
+		done.assign(n, 0);
+		baseSeed = seed;
+		Restart();
+	}
+
+	// Takes effect when game g next starts
+	void SetRules(int game, const GameRules& r) { rules[game] = r; }
+	const GameRules& Rules(int game) const { return rules[game]; }
+
+	// The sizes of the loaded sprites, for --parity
+	void SetRadii(float player, float heart) {
+		playerRadius = player;
+		heartRadius = heart;
+	}
+
+	// Starts every game over from the seed given to Init()
+	void Restart() {
+		episodes.clear();
+		steps = 0;
+		for (int g = 0; g < count; ++g) {
+			rng[g].Seed(baseSeed + static_cast<uint64_t>(g));
+			done[g] = 0;
+			Reset(g);
+			Observe(g);
+		}
+	}
+
+	int Games() const { return count; }
+	uint64_t Steps() const { return steps; }
+	int Score(int game) const { return score[game]; }
+	int HP(int game) const { return hp[game]; }
+
+	// One tick of every game. actions[g] are InputButton bits: the movement buttons and
+	// FIRE act while set, WEAPON and BOOST when they get set (like InputFrame::Pressed).
+	// Games that finished on the previous step restart first.
+	void Step(const uint32_t* actions) {
+		JobPool::Instance().ParallelFor(count / LANES, MIN_BLOCKS_PER_CHUNK, [&](int begin, int end, int) {
+			for (int b = begin; b < end; ++b) StepBlock(b * LANES, actions);
+		});
+		steps++;
+		for (int g = 0; g < count; ++g) {
+			if (done[g]) episodes.push_back({ g, elapsed[g], score[g], hp[g] <= 0, nightmare[g] != 0 });
+		}
+	}
+
+	// Games() x OBS, see Observe()
+	const float* Observations() const { return obs.data(); }
+	// Score gained minus damage taken during the last step
+	const float* Rewards() const { return reward.data(); }
+	// Set for the step a game ended on
+	const uint8_t* Done() const { return done.data(); }
+
+	// Games finished since the last call
+	std::vector<Episode> TakeEpisodes() {
+		std::vector<Episode> out;
+		out.swap(episodes);
+		return out;
+	}
+
+private:
+	// An asteroid filed away in its game's SectorGrid. Asteroids fall asleep and wake up
+	// rarely, so a heap object each is fine.
+	struct Sleeper {
+		Vector2 position;
+		Vector2 velocity;
+		uint8_t size;
+
+		Vector2 GetPosition() const { return position; }
+	};
+	using SleeperPtr = std::unique_ptr<Sleeper>;
+
+	// Asteroid::Drift() without the rotation
+	static void Drift(SleeperPtr& a, float seconds) {
+		Vector2 p = Vector2Add(a->position, Vector2Scale(a->velocity, seconds));
+		p.x -= floorf(p.x / WORLD) * WORLD;
+		p.y -= floorf(p.y / WORLD) * WORLD;
+		a->position = p;
+	}
+
+	static float Uniform(Utils::GameRandom& r, float lo, float hi) {
+		return lo + r.Float01() * (hi - lo);
+	}
+
+	size_t Slot(int k, int g) const { return static_cast<size_t>(k) * count + g; }
+	size_t ShotSlot(int w, int k, int g) const { return (static_cast<size_t>(w) * MAX_SHOTS + k) * count + g; }
+	int& ShotTop(int w, int g) { return shotTop[static_cast<size_t>(w) * count + g]; }
+
+	// ResetGame() with no world population: the spawners draw their first waits in the
+	// order the scripts start
+	void Reset(int g) {
+		px[g] = WORLD * 0.5f;
+		py[g] = WORLD * 0.5f;
+		hp[g] = Ship::MAX_HP;
+		score[g] = 0;
+		boost[g] = 0.f;
+		nightmare[g] = 0;
+		weapon[g] = 0;
+		spawnWaiting[g] = 0;
+		shotTimer[g] = 0.f;
+		elapsed[g] = 0.f;
+		simTime[g] = 0.0;
+		scriptTime[g] = 0.0;
+		for (int k = 0; k < asteroidTop[g]; ++k) ar[Slot(k, g)] = 0.f;
+		for (int w = 0; w < WEAPON_COUNT; ++w) {
+			for (int k = 0; k < ShotTop(w, g); ++k) sr[ShotSlot(w, k, g)] = 0.f;
+			ShotTop(w, g) = 0;
+		}
+		asteroidTop[g] = 0;
+		heartTop[g] = 0;
+		scripts[g].Reset(0);
+		world[g].Init(SECTORS, SECTORS, SECTOR_SIZE);
+		woken[g].clear();
+		FollowPlayer(g);
+		world[g].SetActive(world[g].SectorOf({ cx[g], cy[g] }), ACTIVE_RADIUS, simTime[g], Drift, woken[g]);
+		WaitForAsteroid(g);
+		WaitForHeart(g);
+	}
+
+	void FollowPlayer(int g) {
+		cx[g] = std::clamp(px[g], VIEW * 0.5f, WORLD - VIEW * 0.5f);
+		cy[g] = std::clamp(py[g], VIEW * 0.5f, WORLD - VIEW * 0.5f);
+	}
+
+	Vector2 ViewCorner(int g) const { return { cx[g] - VIEW * 0.5f, cy[g] - VIEW * 0.5f }; }
+
+	// Application::ScheduleExit(): the first sim tick at or after 'seconds' from now, 0 if never
+	uint32_t ExitTick(int g, float seconds) const {
+		if (!(seconds < MAX_EXIT_TIME)) return 0;
+		return static_cast<uint32_t>(ceil((simTime[g] + seconds) * SIM_TICK_RATE));
+	}
+
+	uint32_t AsteroidExit(int g, size_t i) const {
+		Rectangle box = world[g].ActiveBounds();
+		return ExitTick(g, Utils::ExitTime({ ax[i], ay[i] }, { avx[i], avy[i] }, { box.x, box.y }, { box.x + box.width, box.y + box.height }));
+	}
+
+	// Heart::ExitTime(): out through the bottom of the window
+	uint32_t HeartExit(int g, size_t i) const {
+		Rectangle box = world[g].ActiveBounds();
+		return ExitTick(g, Utils::ExitTime({ hx[i], hy[i] }, { 0.f, HEART_SPEED }, { -INFINITY, -INFINITY }, { INFINITY, box.y + box.height }));
+	}
+
+	void AddAsteroid(int g, Vector2 position, Vector2 velocity, uint8_t size) {
+		if (asteroidTop[g] == MAX_ASTEROIDS) return;
+		size_t i = Slot(asteroidTop[g]++, g);
+		ax[i] = position.x;
+		ay[i] = position.y;
+		avx[i] = velocity.x;
+		avy[i] = velocity.y;
+		ar[i] = 16.f * size;
+		asize[i] = size;
+		aflags[i] = 0;
+		aexit[i] = AsteroidExit(g, i);
+	}
+
+	void WakeAsteroids(int g) {
+		for (SleeperPtr& a : woken[g]) AddAsteroid(g, a->position, a->velocity, a->size);
+		woken[g].clear();
+	}
+
+	// ScriptScheduler::ResumeAfter()
+	void ResumeAfter(int g, uint8_t script, float seconds) {
+		scripts[g].Schedule(static_cast<uint32_t>(ceil((scriptTime[g] + seconds) * ScriptScheduler::TICK_RATE)), script);
+	}
+
+	void WaitForAsteroid(int g) {
+		float scale = nightmare[g] ? 0.5f : 1.0f;
+		ResumeAfter(g, SCRIPT_ASTEROIDS, Uniform(rng[g], rules[g].spawnMin * scale, rules[g].spawnMax * scale));
+	}
+
+	void WaitForHeart(int g) {
+		ResumeAfter(g, SCRIPT_HEARTS, Uniform(rng[g], rules[g].heartMin, rules[g].heartMax));
+	}
+
+	// The AsteroidSpawner script after a wait: MakeAsteroid() and Asteroid::init() in view
+	// space, drawing the same random numbers in the same order, then moved into the view.
+	// Asteroid's constructor never passes 'nightmare' on, so speeds are the same in both modes.
+	void SpawnAsteroid(int g) {
+		Vector2 view = ViewCorner(g);
+		int inView = 0;
+		for (int k = 0; k < asteroidTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			if (Utils::Overlaps({ ax[i], ay[i] }, ar[i], { view.x, view.y, VIEW, VIEW })) inView++;
+		}
+		if (inView >= MAX_IN_VIEW || asteroidTop[g] == MAX_ASTEROIDS) {
+			spawnWaiting[g] = 1;
+			return;
+		}
+
+		Utils::GameRandom& r = rng[g];
+		if (!nightmare[g]) r.Int(0, 2); // shape; the nightmare triangle draws nothing
+		uint8_t size = static_cast<uint8_t>(1 << r.Int(0, 2));
+		float radius = 16.f * size;
+		Vector2 p;
+		switch (r.Int(0, 3)) {
+		case 0: p = { Uniform(r, 0, VIEW), -radius }; break;
+		case 1: p = { VIEW + radius, Uniform(r, 0, VIEW) }; break;
+		case 2: p = { Uniform(r, 0, VIEW), VIEW + radius }; break;
+		default: p = { -radius, Uniform(r, 0, VIEW) }; break;
+		}
+		float maxOff = VIEW * 0.1f;
+		float ang = Uniform(r, 0, 2 * PI);
+		float rad = Uniform(r, 0, maxOff);
+		Vector2 center = { VIEW * 0.5f + cosf(ang) * rad, VIEW * 0.5f + sinf(ang) * rad };
+		Vector2 dir = Vector2Normalize(Vector2Subtract(center, p));
+		Uniform(r, Asteroid::SPEED_MIN, Asteroid::SPEED_MAX); // overwritten below
+		Uniform(r, Asteroid::ROT_MIN, Asteroid::ROT_MAX);
+		Uniform(r, 0, 360);
+		Vector2 velocity = Vector2Scale(dir, Uniform(r, Asteroid::SPEED_MIN, Asteroid::SPEED_MAX));
+		AddAsteroid(g, Vector2Add(p, view), velocity, size);
+		WaitForAsteroid(g);
+	}
+
+	// The HeartSpawner script after a wait. The draw happens even when the pool is full.
+	void SpawnHeart(int g) {
+		Vector2 view = ViewCorner(g);
+		Vector2 p = Vector2Add({ Uniform(rng[g], 50.f, VIEW - 50.f), -30.f }, view);
+		if (heartTop[g] < MAX_HEARTS) {
+			size_t i = Slot(heartTop[g]++, g);
+			hx[i] = p.x;
+			hy[i] = p.y;
+			hflags[i] = 0;
+			hexit[i] = HeartExit(g, i);
+		}
+		WaitForHeart(g);
+	}
+
+	void AddScore(int g, int value) {
+		score[g] += value;
+		boost[g] = std::min(boost[g] + value / 300.0f, 1.0f);
+		reward[g] += static_cast<float>(value);
+	}
+
+	// Tick() for games [g0, g0 + LANES): up to the shot hits per game, the shot hits
+	// across the block, then ResolveEvents() per game
+	void StepBlock(int g0, const uint32_t* actions) {
+		for (int g = g0; g < g0 + LANES; ++g) {
+			if (done[g]) {
+				Reset(g);
+				done[g] = 0;
+			}
+			reward[g] = 0.f;
+			TickGame(g, actions[g]);
+		}
+		ShotHits(g0);
+		for (int g = g0; g < g0 + LANES; ++g) {
+			Resolve(g);
+			elapsed[g] += dt;
+			done[g] = hp[g] <= 0 || elapsed[g] >= limit;
+			Observe(g);
+		}
+	}
+
+	void TickGame(int g, uint32_t action) {
+		uint32_t pressed = action & ~lastAction[g];
+		lastAction[g] = action;
+
+		if (!nightmare[g] && score[g] >= rules[g].nightmareScore) nightmare[g] = 1;
+
+		float mx = ((action & BTN_RIGHT) ? 1.f : 0.f) - ((action & BTN_LEFT) ? 1.f : 0.f);
+		float my = ((action & BTN_DOWN) ? 1.f : 0.f) - ((action & BTN_UP) ? 1.f : 0.f);
+		px[g] = std::clamp(px[g] + mx * PLAYER_SPEED * dt, 0.f, WORLD);
+		py[g] = std::clamp(py[g] + my * PLAYER_SPEED * dt, 0.f, WORLD);
+		StepWorld(g);
+
+		// Power Boost: every asteroid goes, for no points. Applied in Simulate().
+		boostFired[g] = (pressed & BTN_BOOST) && boost[g] >= 1.f;
+		if (pressed & BTN_WEAPON) weapon[g] = static_cast<uint8_t>((weapon[g] + 1) % WEAPON_COUNT);
+
+		const WeaponDef& w = WEAPONS[weapon[g]];
+		float interval = 1.f / w.fireRate;
+		if (action & BTN_FIRE) {
+			shotTimer[g] += dt;
+			while (shotTimer[g] >= interval) {
+				if (ShotTop(weapon[g], g) < MAX_SHOTS) {
+					size_t i = ShotSlot(weapon[g], ShotTop(weapon[g], g)++, g);
+					sx[i] = px[g];
+					sy[i] = py[g] - playerRadius;
+					sr[i] = w.radius;
+				}
+				shotTimer[g] -= interval;
+			}
+		}
+		else if (shotTimer[g] > interval) {
+			shotTimer[g] = fmodf(shotTimer[g], interval);
+		}
+
+		// ScriptScheduler::Update(): the spawner waiting for room first, then the wheel
+		scriptTime[g] += dt;
+		if (spawnWaiting[g]) {
+			spawnWaiting[g] = 0;
+			SpawnAsteroid(g);
+		}
+		scripts[g].Advance(static_cast<uint32_t>(scriptTime[g] * ScriptScheduler::TICK_RATE), [&](uint8_t script) {
+			if (script == SCRIPT_ASTEROIDS) SpawnAsteroid(g);
+			else SpawnHeart(g);
+		});
+
+		Simulate(g);
+	}
+
+	// Application::StepWorld()
+	void StepWorld(int g) {
+		FollowPlayer(g);
+		SectorGrid<SleeperPtr>& grid = world[g];
+		double now = simTime[g];
+		if (grid.SetActive(grid.SectorOf({ cx[g], cy[g] }), ACTIVE_RADIUS, now, Drift, woken[g])) {
+			for (int k = 0; k < asteroidTop[g]; ++k) aexit[Slot(k, g)] = AsteroidExit(g, Slot(k, g));
+			for (int k = 0; k < heartTop[g]; ++k) hexit[Slot(k, g)] = HeartExit(g, Slot(k, g));
+		}
+		// With nothing asleep a refresh goes round every sector once and changes nothing
+		if (grid.Sleeping() > 0) {
+			size_t budget = static_cast<size_t>(grid.Sleeping() * dt / SLEEP_REFRESH) + 1;
+			grid.Refresh(now, budget, Drift, woken[g]);
+		}
+		WakeAsteroids(g);
+	}
+
+	// Simulate() up to the shot hits: exits, hearts, player hits before the asteroids move,
+	// then shots and asteroids move. Gone and dead asteroids get ar == 0, gone shots sr == 0.
+	void Simulate(int g) {
+		simTime[g] += dt;
+		uint32_t tick = static_cast<uint32_t>(simTime[g] * SIM_TICK_RATE);
+		Vector2 player = { px[g], py[g] };
+
+		for (int k = 0; k < asteroidTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			aflags[i] = 0;
+			if (aexit[i] != 0 && tick >= aexit[i]) {
+				aflags[i] = LEAVING;
+				ar[i] = 0.f;
+			}
+		}
+		for (int k = 0; k < heartTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			hy[i] = hy[i] + HEART_SPEED * dt;
+			if (tick >= hexit[i]) hflags[i] = LEAVING;
+			else if (Vector2Distance(player, { hx[i], hy[i] }) < playerRadius + heartRadius) hflags[i] = TOUCHED;
+		}
+		if (hp[g] > 0) {
+			for (int k = 0; k < asteroidTop[g]; ++k) {
+				size_t i = Slot(k, g);
+				if (ar[i] > 0.f && Vector2Distance(player, { ax[i], ay[i] }) < playerRadius + ar[i]) aflags[i] |= TOUCHED;
+			}
+		}
+
+		Rectangle bounds = world[g].ActiveBounds();
+		for (int w = 0; w < WEAPON_COUNT; ++w) {
+			float vy = -WEAPONS[w].Speed();
+			for (int k = 0; k < ShotTop(w, g); ++k) {
+				size_t i = ShotSlot(w, k, g);
+				sy[i] = sy[i] + vy * dt;
+				if (sx[i] < bounds.x || sx[i] > bounds.x + bounds.width || sy[i] < bounds.y || sy[i] > bounds.y + bounds.height) sr[i] = 0.f;
+			}
+		}
+		for (int k = 0; k < asteroidTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			ax[i] = ax[i] + avx[i] * dt;
+			ay[i] = ay[i] + avy[i] * dt;
+		}
+
+		// BOOST_FIRED resolves first: the tick's other asteroid events find them all dead
+		if (boostFired[g]) {
+			for (int k = 0; k < asteroidTop[g]; ++k) {
+				ar[Slot(k, g)] = 0.f;
+				aflags[Slot(k, g)] = 0;
+			}
+			boost[g] = 0.f;
+		}
+	}
+
+	// DetectShotHits() and the ASTEROID_DESTROYED events for the block's games, in
+	// (weapon, shot, asteroid) order: each shot takes the first live asteroid it touches.
+	// One shot slot of all lanes against every asteroid slot at once.
+	void ShotHits(int g0) {
+		int asteroidsTop = 0;
+		for (int g = g0; g < g0 + LANES; ++g) asteroidsTop = std::max(asteroidsTop, asteroidTop[g]);
+
+		for (int w = 0; w < WEAPON_COUNT; ++w) {
+			int shotsTop = 0;
+			for (int g = g0; g < g0 + LANES; ++g) shotsTop = std::max(shotsTop, ShotTop(w, g));
+			for (int s = 0; s < shotsTop; ++s) {
+				size_t srow = ShotSlot(w, s, g0);
+#if defined(__AVX2__)
+				const __m256 zero = _mm256_setzero_ps();
+				__m256 r8 = _mm256_loadu_ps(&sr[srow]);
+				__m256 live = _mm256_cmp_ps(r8, zero, _CMP_GT_OQ);
+				if (_mm256_testz_ps(live, live)) continue;
+				__m256 x8 = _mm256_loadu_ps(&sx[srow]);
+				__m256 y8 = _mm256_loadu_ps(&sy[srow]);
+				for (int k = 0; k < asteroidsTop; ++k) {
+					size_t arow = Slot(k, g0);
+					__m256 a8 = _mm256_loadu_ps(&ar[arow]);
+					__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&ax[arow]), x8);
+					__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&ay[arow]), y8);
+					__m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)); // Vector2LengthSqr, no FMA
+					__m256 reach = _mm256_add_ps(r8, a8);
+					__m256 hit = _mm256_and_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(reach, reach), _CMP_LT_OQ),
+						_mm256_and_ps(_mm256_cmp_ps(r8, zero, _CMP_GT_OQ), _mm256_cmp_ps(a8, zero, _CMP_GT_OQ)));
+					int lanes = _mm256_movemask_ps(hit);
+					if (!lanes) continue;
+					for (int l = 0; l < LANES; ++l) {
+						if (lanes & (1 << l)) Destroy(g0 + l, arow + l);
+					}
+					r8 = _mm256_andnot_ps(hit, r8);
+				}
+				_mm256_storeu_ps(&sr[srow], r8);
+#else
+				for (int l = 0; l < LANES; ++l) {
+					size_t j = srow + l;
+					if (sr[j] == 0.f) continue;
+					for (int k = 0; k < asteroidsTop; ++k) {
+						size_t i = Slot(k, g0) + l;
+						if (ar[i] == 0.f) continue;
+						float dx = ax[i] - sx[j];
+						float dy = ay[i] - sy[j];
+						float reach = sr[j] + ar[i];
+						if (dx * dx + dy * dy < reach * reach) {
+							Destroy(g0 + l, i);
+							sr[j] = 0.f;
+							break;
+						}
+					}
+				}
+#endif
+			}
+		}
+	}
+
+	void Destroy(int g, size_t i) {
+		AddScore(g, asize[i] * 10);
+		ar[i] = 0.f;
+		aflags[i] = 0;
+	}
+
+	// The rest of ResolveEvents(): hearts heal, hits land, then everything is compacted in
+	// order. Asteroids that left the window go to sleep in the world, and any that land in
+	// an awake sector come straight back.
+	void Resolve(int g) {
+		for (int k = 0; k < heartTop[g]; ++k) {
+			if (hflags[Slot(k, g)] == TOUCHED && hp[g] > 0 && hp[g] < Ship::MAX_HP) {
+				hp[g] += std::min(rules[g].heartHeal, Ship::MAX_HP - hp[g]);
+			}
+		}
+		for (int k = 0; k < asteroidTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			if (!(aflags[i] & TOUCHED) || ar[i] == 0.f || hp[g] <= 0) continue;
+			int damage = 5 * asize[i]; // every shape the spawner makes has base damage 5
+			hp[g] -= damage;
+			reward[g] -= static_cast<float>(damage);
+			ar[i] = 0.f;
+		}
+
+		int kept = 0;
+		for (int k = 0; k < asteroidTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			if (ar[i] == 0.f) {
+				if (aflags[i] & LEAVING) {
+					SleeperPtr a = std::make_unique<Sleeper>(Sleeper{ { ax[i], ay[i] }, { avx[i], avy[i] }, asize[i] });
+					Drift(a, 0.f);
+					world[g].Sleep(std::move(a), simTime[g], woken[g]);
+				}
+				continue;
+			}
+			size_t o = Slot(kept++, g);
+			ax[o] = ax[i];
+			ay[o] = ay[i];
+			avx[o] = avx[i];
+			avy[o] = avy[i];
+			ar[o] = ar[i];
+			asize[o] = asize[i];
+			aexit[o] = aexit[i];
+		}
+		for (int k = kept; k < asteroidTop[g]; ++k) ar[Slot(k, g)] = 0.f;
+		asteroidTop[g] = kept;
+
+		for (int w = 0; w < WEAPON_COUNT; ++w) {
+			int top = ShotTop(w, g);
+			kept = 0;
+			for (int k = 0; k < top; ++k) {
+				size_t i = ShotSlot(w, k, g);
+				if (sr[i] == 0.f) continue;
+				size_t o = ShotSlot(w, kept++, g);
+				sx[o] = sx[i];
+				sy[o] = sy[i];
+				sr[o] = sr[i];
+			}
+			for (int k = kept; k < top; ++k) sr[ShotSlot(w, k, g)] = 0.f;
+			ShotTop(w, g) = kept;
+		}
+
+		kept = 0;
+		for (int k = 0; k < heartTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			if (hflags[i] != 0) continue;
+			size_t o = Slot(kept++, g);
+			hx[o] = hx[i];
+			hy[o] = hy[i];
+			hflags[o] = 0;
+			hexit[o] = hexit[i];
+		}
+		heartTop[g] = kept;
+
+		WakeAsteroids(g);
+	}
+
+	// Position in the view, hp, boost charge, nightmare, offset to the lowest heart, then
+	// the NEAREST awake asteroids by distance: offset, velocity, radius. Scaled to about
+	// [-1, 1]; missing entries are zeros.
+	void Observe(int g) {
+		float* o = &obs[static_cast<size_t>(g) * OBS];
+		std::fill(o, o + OBS, 0.f);
+		Vector2 view = ViewCorner(g);
+		o[0] = (px[g] - view.x) / VIEW;
+		o[1] = (py[g] - view.y) / VIEW;
+		o[2] = static_cast<float>(hp[g]) / Ship::MAX_HP;
+		o[3] = boost[g];
+		o[4] = nightmare[g] ? 1.f : 0.f;
+		int lowest = -1;
+		for (int k = 0; k < heartTop[g]; ++k) {
+			if (lowest < 0 || hy[Slot(k, g)] > hy[Slot(lowest, g)]) lowest = k;
+		}
+		if (lowest >= 0) {
+			o[5] = (hx[Slot(lowest, g)] - px[g]) / VIEW;
+			o[6] = (hy[Slot(lowest, g)] - py[g]) / VIEW;
+		}
+
+		int nearest[NEAREST];
+		float best[NEAREST];
+		int found = 0;
+		for (int k = 0; k < asteroidTop[g]; ++k) {
+			size_t i = Slot(k, g);
+			float dx = ax[i] - px[g];
+			float dy = ay[i] - py[g];
+			float d2 = dx * dx + dy * dy;
+			if (found == NEAREST && d2 >= best[NEAREST - 1]) continue;
+			int at = found < NEAREST ? found++ : NEAREST - 1;
+			while (at > 0 && best[at - 1] > d2) {
+				best[at] = best[at - 1];
+				nearest[at] = nearest[at - 1];
+				at--;
+			}
+			best[at] = d2;
+			nearest[at] = k;
+		}
+		for (int n = 0; n < found; ++n) {
+			size_t i = Slot(nearest[n], g);
+			float* a = o + 7 + n * 5;
+			a[0] = (ax[i] - px[g]) / VIEW;
+			a[1] = (ay[i] - py[g]) / VIEW;
+			a[2] = avx[i] / Asteroid::SPEED_MAX;
+			a[3] = avy[i] / Asteroid::SPEED_MAX;
+			a[4] = ar[i] / 64.f;
+		}
+	}
+
+	// Application's world constants
+	static constexpr float VIEW = 1200.f;          // C_WIDTH and C_HEIGHT
+	static constexpr int SECTORS = 16;             // C_WORLD_SECTORS
+	static constexpr float SECTOR_SIZE = 1200.f;   // C_SECTOR_SIZE
+	static constexpr float WORLD = SECTORS * SECTOR_SIZE;
+	static constexpr int ACTIVE_RADIUS = 1;        // C_ACTIVE_RADIUS
+	static constexpr float SLEEP_REFRESH = 1.f;    // C_SLEEP_REFRESH
+	static constexpr float MAX_EXIT_TIME = 3600.f; // C_MAX_EXIT_TIME
+	static constexpr int MAX_IN_VIEW = 150;        // MAX_AST
+
+	enum : uint8_t { SCRIPT_ASTEROIDS, SCRIPT_HEARTS };
+	enum : uint8_t { TOUCHED = 1, LEAVING = 2 }; // aflags and hflags, for the current tick
+
+	int count = 0;
+	uint64_t baseSeed = 0;
+	float dt = 1.f / 60.f;
+	float limit = 300.f;
+	float playerRadius = PLAYER_RADIUS;
+	float heartRadius = HEART_RADIUS;
+	uint64_t steps = 0;
+
+	// Per game
+	std::vector<float> px, py;
+	std::vector<float> cx, cy; // camera target
+	std::vector<int> hp, score;
+	std::vector<float> boost;
+	std::vector<uint8_t> nightmare, weapon, boostFired;
+	std::vector<uint8_t> spawnWaiting; // the asteroid spawner waits for room, tick by tick
+	std::vector<uint32_t> lastAction;
+	std::vector<float> shotTimer, elapsed;
+	std::vector<double> simTime, scriptTime;
+	std::vector<int> asteroidTop, heartTop;
+	std::vector<int> shotTop; // [weapon * count + game]
+	std::vector<Utils::GameRandom> rng;
+	std::vector<GameRules> rules;
+	std::vector<TimingWheel<uint8_t>> scripts;
+	std::vector<SectorGrid<SleeperPtr>> world;
+	std::vector<std::vector<SleeperPtr>> woken;
+
+	// [slot * count + game], shots [(weapon * MAX_SHOTS + slot) * count + game]
+	std::vector<float> ax, ay, avx, avy, ar; // ar == 0: gone, dead or free
+	std::vector<uint8_t> asize, aflags;
+	std::vector<uint32_t> aexit;
+	std::vector<float> sx, sy, sr;           // sr == 0: gone, spent or free
+	std::vector<float> hx, hy;
+	std::vector<uint8_t> hflags;
+	std::vector<uint32_t> hexit;
+
+	std::vector<float> obs;
+	std::vector<float> reward;
+	std::vector<uint8_t> done;
+	std::vector<Episode> episodes;
+};
+
+// --- BOTS ---
+// Pick actions from the observations only, so a scripted bot and a trained policy see
+// the same thing.
+namespace Bots {
+	// Holds a random direction for a while and fires half the time
+	inline uint32_t Random(Utils::GameRandom& r, uint32_t previous) {
+		if (r.Int(0, 14) != 0) return previous;
+		static constexpr uint32_t MOVES[] = { 0, BTN_UP, BTN_DOWN, BTN_LEFT, BTN_RIGHT,
+			BTN_UP | BTN_LEFT, BTN_UP | BTN_RIGHT, BTN_DOWN | BTN_LEFT, BTN_DOWN | BTN_RIGHT };
+		uint32_t a = MOVES[r.Int(0, 8)];
+		if (r.Int(0, 1)) a |= BTN_FIRE;
+		if (r.Int(0, 9) == 0) a |= BTN_BOOST;
+		return a;
+	}
+
+	// Steps sideways out of the path of the most urgent asteroid, heads for a heart when
+	// hurt, otherwise keeps to the middle of the view and fires. Boosts when cornered.
+	inline uint32_t Dodge(const float* o) {
+		static constexpr float LOOKAHEAD = 1.2f;
+		static constexpr float CLEARANCE = 70.f / 1200.f;
+		float moveX = 0.f, moveY = 0.f;
+		float soonest = LOOKAHEAD;
+		int threats = 0;
+		for (int n = 0; n < BatchEnv::NEAREST; ++n) {
+			const float* a = o + 7 + n * 5;
+			if (a[4] == 0.f) break;
+			float vx = a[2] * Asteroid::SPEED_MAX / 1200.f;
+			float vy = a[3] * Asteroid::SPEED_MAX / 1200.f;
+			float v2 = vx * vx + vy * vy;
+			float t = v2 > 0.f ? -(a[0] * vx + a[1] * vy) / v2 : 0.f;
+			if (t < 0.f || t > LOOKAHEAD) continue;
+			float cx = a[0] + vx * t;
+			float cy = a[1] + vy * t;
+			float reach = (a[4] * 64.f + BatchEnv::PLAYER_RADIUS) / 1200.f + CLEARANCE;
+			if (cx * cx + cy * cy > reach * reach) continue;
+			threats++;
+			if (t < soonest) {
+				soonest = t;
+				// Away from where it passes closest, or sideways if it comes straight at us
+				if (fabsf(cx) + fabsf(cy) > 1e-4f) {
+					moveX = -cx;
+					moveY = -cy;
+				}
+				else {
+					moveX = -vy;
+					moveY = vx;
+				}
+			}
+		}
+
+		uint32_t a = BTN_FIRE;
+		if (threats >= 3 && o[3] >= 1.f) a |= BTN_BOOST;
+		if (threats == 0) {
+			bool heart = o[5] != 0.f || o[6] != 0.f;
+			if (heart && o[2] < 0.7f && o[6] > -0.5f) {
+				moveX = o[5];
+				moveY = o[6];
+			}
+			else {
+				moveX = 0.5f - o[0];
+				moveY = 0.5f - o[1];
+			}
+		}
+		static constexpr float DEAD_ZONE = 0.01f;
+		if (moveX > DEAD_ZONE) a |= BTN_RIGHT;
+		if (moveX < -DEAD_ZONE) a |= BTN_LEFT;
+		if (moveY > DEAD_ZONE) a |= BTN_DOWN;
+		if (moveY < -DEAD_ZONE) a |= BTN_UP;
+		return a;
+	}
+}
+
+// --- RUNNER ---
+namespace Batch {
+	using Clock = std::chrono::steady_clock;
+
+	struct Sweep {
+		std::string rule;
+		std::vector<float> values{ 0.f }; // one group with the base rules when not sweeping
+	};
+
+	static bool SetRule(GameRules& r, const std::string& name, float v) {
+		if (name == "spawn-min") r.spawnMin = v;
+		else if (name == "spawn-max") r.spawnMax = v;
+		else if (name == "heal") r.heartHeal = static_cast<int>(v);
+		else if (name == "nightmare") r.nightmareScore = static_cast<int>(v);
+		else return false;
+		return true;
+	}
+
+	struct Group {
+		std::vector<float> seconds;
+		double score = 0.0;
+		int died = 0;
+		int nightmare = 0;
+	};
+
+	static float Percentile(std::vector<float>& v, double p) {
+		if (v.empty()) return 0.f;
+		size_t k = static_cast<size_t>(p * (v.size() - 1));
+		std::nth_element(v.begin(), v.begin() + k, v.end());
+		return v[k];
+	}
+
+	static void SeedBots(std::vector<Utils::GameRandom>& bots, uint64_t seed) {
+		for (size_t g = 0; g < bots.size(); ++g) bots[g].Seed(seed ^ 0xB07B07ull ^ static_cast<uint64_t>(g));
+	}
+
+	// Records the first game of 'games' environments under the random bot, then plays the
+	// same seeds and inputs through Application::Tick() and compares HP and score after
+	// every tick. Returns the number of games that differ.
+	static int Parity(int games, uint64_t seed, float seconds, GameRules rules) {
+		static constexpr float DT = 1.f / 60.f;
+		rules.swarms = false;
+		SetConfigFlags(FLAG_WINDOW_HIDDEN);
+		InitWindow(64, 64, "BatchRun parity");
+		Application& app = Application::Instance();
+		app.StartGame(rules, seed, 0); // loads the sprites, for their sizes
+
+		BatchEnv env;
+		env.SetRadii(app.PlayerRadius(), Heart::Radius());
+		env.Init(games, seed, DT, seconds);
+		for (int g = 0; g < env.Games(); ++g) env.SetRules(g, rules);
+		env.Restart();
+
+		struct Trace {
+			std::vector<uint32_t> actions;
+			std::vector<int> hp, score;
+			bool finished = false;
+		};
+		std::vector<Trace> traces(games);
+		std::vector<uint32_t> actions(env.Games(), 0);
+		std::vector<Utils::GameRandom> bots(env.Games());
+		SeedBots(bots, seed);
+		for (int left = games; left > 0;) {
+			for (int g = 0; g < env.Games(); ++g) actions[g] = Bots::Random(bots[g], actions[g]);
+			env.Step(actions.data());
+			for (int g = 0; g < games; ++g) {
+				Trace& t = traces[g];
+				if (t.finished) continue;
+				t.actions.push_back(actions[g]);
+				t.hp.push_back(env.HP(g));
+				t.score.push_back(env.Score(g));
+				if (env.Done()[g]) {
+					t.finished = true;
+					left--;
+				}
+			}
+		}
+
+		int failed = 0;
+		for (int g = 0; g < games; ++g) {
+			const Trace& t = traces[g];
+			unsigned long long gameSeed = seed + static_cast<uint64_t>(g);
+			app.StartGame(rules, gameSeed, 0);
+			uint32_t last = 0;
+			size_t tick = 0;
+			for (; tick < t.actions.size(); ++tick) {
+				InputFrame in;
+				in.dt = DT;
+				in.down = t.actions[tick];
+				in.pressed = t.actions[tick] & ~last;
+				last = t.actions[tick];
+				app.Step(in);
+				if (app.PlayerHP() != t.hp[tick] || app.Score() != t.score[tick]) break;
+			}
+			if (tick < t.actions.size()) {
+				failed++;
+				printf("seed %llu: differs at tick %zu: game hp %d score %d, BatchEnv hp %d score %d\n",
+					gameSeed, tick, app.PlayerHP(), app.Score(), t.hp[tick], t.score[tick]);
+			}
+			else {
+				printf("seed %llu: same for %zu ticks, %s with hp %d, score %d\n", gameSeed, tick,
+					t.hp.back() <= 0 ? "died" : "timed out", t.hp.back(), t.score.back());
+			}
+		}
+		app.StopGame();
+		CloseWindow();
+		printf("parity: %d of %d games differ\n", failed, games);
+		return failed;
+	}
+}
+
+int main(int argc, char** argv) {
+	int games = 10'000;
+	int envs = 1024;
+	int parityGames = 0;
+	bool randomBot = true;
+	float seconds = 300.f;
+	uint64_t seed = 1;
+	GameRules base;
+	Batch::Sweep sweep;
+	for (int i = 1; i < argc; ++i) {
+		auto next = [&]() { return i + 1 < argc ? argv[++i] : "0"; };
+		if (!strcmp(argv[i], "--games")) games = std::max(atoi(next()), 1);
+		else if (!strcmp(argv[i], "--envs")) envs = std::max(atoi(next()), 1);
+		else if (!strcmp(argv[i], "--bot")) randomBot = strcmp(next(), "dodge") != 0;
+		else if (!strcmp(argv[i], "--seconds")) seconds = strtof(next(), nullptr);
+		else if (!strcmp(argv[i], "--seed")) seed = strtoull(next(), nullptr, 10);
+		else if (!strcmp(argv[i], "--spawn-min")) base.spawnMin = strtof(next(), nullptr);
+		else if (!strcmp(argv[i], "--spawn-max")) base.spawnMax = strtof(next(), nullptr);
+		else if (!strcmp(argv[i], "--heal")) base.heartHeal = atoi(next());
+		else if (!strcmp(argv[i], "--nightmare")) base.nightmareScore = atoi(next());
+		else if (!strcmp(argv[i], "--parity")) parityGames = std::max(atoi(next()), 1);
+		else if (!strcmp(argv[i], "--sweep")) {
+			std::string spec = next();
+			size_t eq = spec.find('=');
+			sweep.rule = spec.substr(0, eq);
+			sweep.values.clear();
+			for (size_t at = eq; at != std::string::npos && at + 1 < spec.size();) {
+				sweep.values.push_back(strtof(spec.c_str() + at + 1, nullptr));
+				at = spec.find(',', at + 1);
+			}
+			GameRules probe;
+			if (eq == std::string::npos || sweep.values.empty() || !Batch::SetRule(probe, sweep.rule, 0.f)) {
+				fprintf(stderr, "--sweep expects rule=v1,v2,... with rule one of spawn-min, spawn-max, heal, nightmare\n");
+				return 1;
+			}
+		}
+	}
+	SetTraceLogLevel(LOG_WARNING);
+	if (parityGames > 0) return Batch::Parity(parityGames, seed, seconds, base) ? 1 : 0;
+
+	// No more environments than games; the lanes that round the last block up play
+	// along but are not counted
+	int groups = static_cast<int>(sweep.values.size());
+	games = std::max(games, groups);
+	int active = std::clamp(envs, groups, games);
+	BatchEnv env;
+	env.Init(active, seed, 1.f / 60.f, seconds);
+	envs = env.Games();
+	std::vector<int> groupOf(envs);
+	for (int g = 0; g < envs; ++g) {
+		groupOf[g] = static_cast<int>(static_cast<int64_t>(std::min(g, active - 1)) * groups / active);
+		GameRules r = base;
+		if (!sweep.rule.empty()) Batch::SetRule(r, sweep.rule, sweep.values[groupOf[g]]);
+		env.SetRules(g, r);
+	}
+	env.Restart();
+
+	// Every environment contributes exactly its quota, the first games it finishes, so
+	// short games are not over-represented. The quotas add up to --games.
+	std::vector<int> quota(envs, 0);
+	for (int g = 0; g < active; ++g) quota[g] = games / active + (g < games % active ? 1 : 0);
+	std::vector<int> finished(envs, 0);
+	std::vector<Batch::Group> results(groups);
+	std::vector<uint32_t> actions(envs, 0);
+	std::vector<Utils::GameRandom> botRng(envs);
+	Batch::SeedBots(botRng, seed);
+
+	printf("%d games on %d environments, %s bot, %d workers, up to %.0f s each\n",
+		games, active, randomBot ? "random" : "dodge", JobPool::Instance().Workers(), seconds);
+
+	Batch::Clock::time_point start = Batch::Clock::now();
+	double stepSeconds = 0.0;
+	int complete = envs - active;
+	size_t played = 0;
+	while (complete < envs) {
+		const float* obs = env.Observations();
+		for (int g = 0; g < envs; ++g) {
+			actions[g] = randomBot ? Bots::Random(botRng[g], actions[g]) : Bots::Dodge(obs + static_cast<size_t>(g) * BatchEnv::OBS);
+		}
+		Batch::Clock::time_point t0 = Batch::Clock::now();
+		env.Step(actions.data());
+		stepSeconds += std::chrono::duration<double>(Batch::Clock::now() - t0).count();
+
+		for (const BatchEnv::Episode& e : env.TakeEpisodes()) {
+			played++;
+			if (finished[e.game] == quota[e.game]) continue;
+			Batch::Group& r = results[groupOf[e.game]];
+			r.seconds.push_back(e.seconds);
+			r.score += e.score;
+			r.died += e.died;
+			r.nightmare += e.nightmare;
+			if (++finished[e.game] == quota[e.game]) complete++;
+		}
+	}
+	double wall = std::chrono::duration<double>(Batch::Clock::now() - start).count();
+
+	printf("%-12s %7s %10s %10s %10s %8s %9s %9s\n", sweep.rule.empty() ? "rules" : sweep.rule.c_str(),
+		"games", "mean s", "p10 s", "p50 s", "died", "score", "nightmare");
+	for (int k = 0; k < groups; ++k) {
+		Batch::Group& r = results[k];
+		double n = static_cast<double>(std::max<size_t>(r.seconds.size(), 1));
+		double sum = 0.0;
+		for (float s : r.seconds) sum += s;
+		char label[32];
+		if (sweep.rule.empty()) snprintf(label, sizeof(label), "base");
+		else snprintf(label, sizeof(label), "%g", sweep.values[k]);
+		printf("%-12s %7zu %10.1f %10.1f %10.1f %7.1f%% %9.0f %8.1f%%\n", label, r.seconds.size(), sum / n,
+			Batch::Percentile(r.seconds, 0.1), Batch::Percentile(r.seconds, 0.5), 100.0 * r.died / n, r.score / n,
+			100.0 * r.nightmare / n);
+	}
+	double gameSteps = static_cast<double>(env.Steps()) * envs;
+	printf("%zu games (%zu counted) in %.2f s: %.0f games/s, %.2f M game-steps/s (%.2f M/s in Step)\n",
+		played, static_cast<size_t>(games), wall, played / wall, gameSteps / wall * 1e-6, gameSteps / stepSeconds * 1e-6);
+	return 0;
+}
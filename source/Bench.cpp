@@ -0,0 +1,520 @@
+// Microbenchmarks for the game's hot kernels. Pulls in the game as a unity
+// build without its main() and runs everything headless (no window, no GL).
+//
+//   Bench [--baseline file] [--write-baseline file] [--filter text]
+//
+// --write-baseline stores the results; with --filter only the kernels that ran are
+// replaced and the rest of the file is kept.
+//
+// With --baseline every kernel slower than the stored value by more than
+// REGRESSION_LIMIT is reported and the exit code is 1. Kernels that check their output
+// against a slow reference (light_binning) also exit with 1 on a mismatch.
+
+#define _CRT_SECURE_NO_WARNINGS
+#define UNICORNS_NO_MAIN
+#include "Main.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <map>
+
+namespace Bench {
+	static constexpr double REGRESSION_LIMIT = 0.10;
+	static constexpr int SCREEN_W = 1200;
+	static constexpr int SCREEN_H = 1200;
+	static constexpr int REPEATS = 7;
+	static constexpr double MIN_REPEAT_SECONDS = 0.05;
+
+	using Clock = std::chrono::steady_clock;
+
+	// Keeps the optimizer from dropping results
+	static volatile float sink = 0.f;
+
+	struct Result {
+		std::string name;
+		const char* unit;
+		double nsPerUnit;
+	};
+
+	// Runs setup() (untimed) + kernel() until MIN_REPEAT_SECONDS are spent, REPEATS
+	// times, and keeps the best ns per processed unit. kernel() returns the unit count.
+	template<typename Setup, typename Kernel>
+	double Measure(Setup&& setup, Kernel&& kernel) {
+		double best = 1e30;
+		for (int r = 0; r < REPEATS; ++r) {
+			double spent = 0.0;
+			double units = 0.0;
+			while (spent < MIN_REPEAT_SECONDS) {
+				setup();
+				auto t0 = Clock::now();
+				units += static_cast<double>(kernel());
+				auto t1 = Clock::now();
+				spent += std::chrono::duration<double>(t1 - t0).count();
+			}
+			double ns = spent * 1e9 / (units > 0 ? units : 1);
+			if (ns < best) best = ns;
+		}
+		return best;
+	}
+
+	// Alternating weapons, n shots in total
+	static ShotArrays MakeShots(int n) {
+		ShotArrays out;
+		for (int i = 0; i < n; ++i) {
+			Vector2 p{ Utils::RandomFloat(0, SCREEN_W), Utils::RandomFloat(0, SCREEN_H) };
+			out[i % WEAPON_COUNT].push_back({ p, { 0, -Utils::RandomFloat(400.f, 900.f) }, 0 });
+		}
+		return out;
+	}
+
+	// Per-weapon flags for every shot in 'shots'
+	static std::array<std::vector<uint8_t>, WEAPON_COUNT> ShotFlags(const ShotArrays& shots) {
+		std::array<std::vector<uint8_t>, WEAPON_COUNT> out;
+		for (int w = 0; w < WEAPON_COUNT; ++w) out[w].assign(shots[w].size(), 0);
+		return out;
+	}
+
+	static std::vector<std::unique_ptr<Asteroid>> MakeAsteroids(int n) {
+		std::vector<std::unique_ptr<Asteroid>> out;
+		out.reserve(n);
+		for (int i = 0; i < n; ++i) {
+			out.push_back(MakeAsteroid(SCREEN_W, SCREEN_H, AsteroidShape::RANDOM, i % 2 == 0));
+		}
+		return out;
+	}
+
+	// Asteroids spawn on the screen edges; move them inside so the sweep finds hits
+	static void Scatter(std::vector<std::unique_ptr<Asteroid>>& asteroids, float dt) {
+		for (auto& a : asteroids) {
+			for (int i = 0; i < 30; ++i) a->Update(dt);
+		}
+	}
+
+	// Waits a random 0.1-2 s over and over, like a spawner
+	static Task WaitLoop(uint32_t seed, uint64_t* resumes) {
+		for (;;) {
+			seed = seed * 1664525u + 1013904223u;
+			co_await Seconds(0.1f + (seed >> 8) * (1.9f / 16777216.f));
+			(*resumes)++;
+		}
+	}
+
+	static Task OneShot(uint64_t* done) {
+		co_await NextTick;
+		(*done)++;
+	}
+
+	struct Light {
+		Vector2 p;
+		float radius;
+	};
+
+	// Tiles whose binned list differs from testing every light against every tile. Full
+	// tiles keep the first TILE_SLOTS - 1 overlapping lights in index order.
+	static int CheckLightTiles(const LightTiles& tiles, const std::vector<Light>& lights) {
+		constexpr int T = LightTiles::TILE;
+		int bad = 0;
+		std::vector<uint32_t> expected;
+		for (int ty = 0; ty < tiles.Rows(); ++ty) {
+			for (int tx = 0; tx < tiles.Columns(); ++tx) {
+				expected.clear();
+				for (size_t i = 0; i < lights.size() && expected.size() < static_cast<size_t>(LightTiles::TILE_SLOTS - 1); ++i) {
+					const Light& l = lights[i];
+					float dx = std::max({ tx * T - l.p.x, l.p.x - (tx + 1) * T, 0.f });
+					float dy = std::max({ ty * T - l.p.y, l.p.y - (ty + 1) * T, 0.f });
+					// Same rounding as BinRow, so lights grazing a corner agree too
+					if (dx * dx < l.radius * l.radius - dy * dy) expected.push_back(static_cast<uint32_t>(i));
+				}
+				bool same = tiles.TileCount(tx, ty) == static_cast<int>(expected.size());
+				for (size_t k = 0; same && k < expected.size(); ++k) {
+					same = tiles.TileLight(tx, ty, static_cast<int>(k)) == expected[k];
+				}
+				bad += !same;
+			}
+		}
+		return bad;
+	}
+
+	// Kernels whose output failed its check
+	static int failures = 0;
+
+	static std::vector<Result> Run(const char* filter) {
+		std::vector<Result> results;
+		auto enabled = [filter](const std::string& name) {
+			return filter == nullptr || name.find(filter) != std::string::npos;
+		};
+		auto add = [&results](std::string name, const char* unit, double ns) {
+			printf("%-32s %10.2f ns/%s\n", name.c_str(), ns, unit);
+			results.push_back({ std::move(name), unit, ns });
+		};
+
+		if (enabled("asteroid_spawn")) {
+			constexpr int N = 1000;
+			std::vector<std::unique_ptr<Asteroid>> asteroids;
+			asteroids.reserve(N);
+			double ns = Measure([&] { asteroids.clear(); }, [&] {
+				for (int i = 0; i < N; ++i) {
+					asteroids.push_back(MakeAsteroid(SCREEN_W, SCREEN_H, AsteroidShape::RANDOM, i % 2 == 0));
+				}
+				return N;
+			});
+			add("asteroid_spawn", "asteroid", ns);
+		}
+
+		if (enabled("projectile_update")) {
+			constexpr int N = 10'000;
+			const ShotArrays source = MakeShots(N);
+			ShotArrays shots;
+			auto gone = ShotFlags(source);
+			auto dead = ShotFlags(source);
+			for (auto& d : dead) {
+				for (size_t i = 0; i < d.size(); i += 7) d[i] = 1; // some hit something every tick
+			}
+			EventBuffer expired;
+			Rectangle bounds{ -1e6f, -1e6f, 2e6f, 2e6f };
+			double ns = Measure([&] { shots = source; expired.Clear(); }, [&] {
+				ForEachWeapon([&](auto w) {
+					constexpr int W = static_cast<int>(decltype(w)::value);
+					AdvanceShots<w>(shots[W], gone[W], bounds, 1.f / 60.f, 0, static_cast<int>(shots[W].size()), expired);
+					CompactByFlags(shots[W], dead[W]);
+				});
+				return N;
+			});
+			add("projectile_update_compact", "projectile", ns);
+		}
+
+		if (enabled("exit_wheel")) {
+			// Schedule + expire through the timing wheel, spread over a few seconds of ticks
+			constexpr int N = 10'000;
+			constexpr uint32_t SPAN = 600;
+			TimingWheel<uint32_t> wheel;
+			double ns = Measure([&] { wheel.Reset(0); }, [&] {
+				uint32_t fired = 0;
+				for (int i = 0; i < N; ++i) wheel.Schedule(1 + (static_cast<uint32_t>(i) * 7919u) % SPAN, static_cast<uint32_t>(i));
+				wheel.Advance(SPAN, [&](uint32_t) { fired++; });
+				sink = sink + static_cast<float>(fired);
+				return N;
+			});
+			add("exit_wheel", "entity", ns);
+		}
+
+		if (enabled("script")) {
+			// Many suspended scripts, only the due ones cost anything
+			constexpr int N = 10'000;
+			ScriptScheduler scheduler;
+			uint64_t resumes = 0;
+			for (int i = 0; i < N; ++i) scheduler.Start(WaitLoop(static_cast<uint32_t>(i), &resumes));
+			double ns = Measure([] {}, [&] {
+				uint64_t before = resumes;
+				for (int t = 0; t < 60; ++t) scheduler.Update(1.f / 60.f);
+				return resumes - before;
+			});
+			add("script_resume", "resume", ns);
+
+			// Start + finish through the pooled frame allocator
+			uint64_t done = 0;
+			ns = Measure([] {}, [&] {
+				for (int i = 0; i < N; ++i) scheduler.Start(OneShot(&done));
+				scheduler.Update(1.f / 60.f);
+				return N;
+			});
+			add("script_oneshot", "script", ns);
+		}
+
+		const int sweeps[][2] = { { 100, 50 }, { 1000, 150 }, { 5000, 150 } };
+		for (const auto& nm : sweeps) {
+			std::string name = "collision_" + std::to_string(nm[0]) + "x" + std::to_string(nm[1]);
+			if (!enabled(name)) continue;
+			ShotArrays shots = MakeShots(nm[0]);
+			const auto gone = ShotFlags(shots);
+			Utils::Rng().Seed(nm[0] + nm[1]);
+			std::vector<std::unique_ptr<Asteroid>> asteroids = MakeAsteroids(nm[1]);
+			const std::vector<uint8_t> asteroidGone(asteroids.size(), 0);
+			Scatter(asteroids, 1.f / 60.f);
+			auto fullSweep = [&] {
+				for (auto& s : shots) {
+					for (Shot& shot : s) shot.nextCheckTick = 0;
+				}
+			};
+			auto sweep = [&](uint32_t tick, EventBuffer& out) {
+				ForEachWeapon([&](auto w) {
+					constexpr int W = static_cast<int>(decltype(w)::value);
+					DetectShotHits<w>(shots[W], gone[W], asteroids, asteroidGone, tick, 0, static_cast<int>(shots[W].size()), out);
+				});
+			};
+			EventBuffer events;
+			double ns = Measure([&] { fullSweep(); events.Clear(); }, [&] {
+				sweep(0, events);
+				return nm[0] * nm[1];
+			});
+			add(name, "pair", ns);
+
+			// Same sweep split across the job pool, one event buffer per worker
+			EventQueue queue;
+			queue.Reserve(JobPool::Instance().Workers());
+			ns = Measure([&] { fullSweep(); queue.Resolve([](const GameEvent&) {}); }, [&] {
+				ForEachWeapon([&](auto w) {
+					constexpr int W = static_cast<int>(decltype(w)::value);
+					JobPool::Instance().ParallelFor(static_cast<int>(shots[W].size()), 256, [&](int begin, int end, int worker) {
+						DetectShotHits<w>(shots[W], gone[W], asteroids, asteroidGone, 0, begin, end, queue.Buffer(worker));
+					});
+				});
+				return nm[0] * nm[1];
+			});
+			add(name + "_mt", "pair", ns);
+
+			// Steady state: one tick later most projectiles wait for a predicted contact
+			ns = Measure([&] {
+				fullSweep();
+				events.Clear();
+				sweep(0, events);
+				events.Clear();
+			}, [&] {
+				sweep(1, events);
+				return nm[0] * nm[1];
+			});
+			add(name + "_predicted", "pair", ns);
+		}
+
+		if (enabled("outline")) {
+			constexpr int N = 1000;
+			Vector2 points[HEART_SEGMENTS > FLOWER_SEGMENTS ? HEART_SEGMENTS : FLOWER_SEGMENTS];
+			auto none = [] {};
+			add("outline_heart", "outline", Measure(none, [&] {
+				for (int i = 0; i < N; ++i) {
+					BuildHeartOutline(points, { 600.f, 600.f }, 64.f, static_cast<float>(i));
+					sink = sink + points[i % HEART_SEGMENTS].x;
+				}
+				return N;
+			}));
+			add("outline_star", "outline", Measure(none, [&] {
+				for (int i = 0; i < N; ++i) {
+					BuildStarOutline(points, { 600.f, 600.f }, 64.f, static_cast<float>(i));
+					sink = sink + points[i % STAR_POINTS].x;
+				}
+				return N;
+			}));
+			add("outline_flower", "outline", Measure(none, [&] {
+				for (int i = 0; i < N; ++i) {
+					BuildFlowerOutline(points, { 600.f, 600.f }, 64.f, static_cast<float>(i));
+					sink = sink + points[i % FLOWER_SEGMENTS].x;
+				}
+				return N;
+			}));
+			// GPU path: the CPU only packs one instance per asteroid
+			AsteroidSdfRenderer sdf;
+			add("outline_sdf_submit", "outline", Measure([&] { sdf.Clear(); }, [&] {
+				for (int i = 0; i < N; ++i) {
+					sdf.Submit({ 600.f, 600.f }, 64.f, static_cast<float>(i), AsteroidSdfRenderer::FLOWER, MAGENTA);
+				}
+				return N;
+			}));
+		}
+
+		if (enabled("heart_update")) {
+			constexpr int N = 10'000;
+			std::vector<Heart> hearts;
+			hearts.reserve(N);
+			for (int i = 0; i < N; ++i) hearts.emplace_back(SCREEN_W, SCREEN_H);
+			double ns = Measure([] {}, [&] {
+				AdvanceHearts(hearts, 1.f / 60.f, 0, N);
+				sink = sink + hearts[N - 1].GetPosition().y;
+				return N;
+			});
+			add("heart_update", "heart", ns);
+		}
+
+		if (enabled("sector_refresh")) {
+			// 100k sleepers in a 16x16 world, caught up a sector at a time. Most stay where
+			// they are, a few refile or wake up each pass.
+			constexpr int N = 100'000;
+			constexpr float SECTOR = 1200.f;
+			SectorGrid<std::unique_ptr<Asteroid>> world;
+			world.Init(16, 16, SECTOR);
+			std::vector<std::unique_ptr<Asteroid>> woken;
+			Vector2 size = world.WorldSize();
+			auto drift = [size](std::unique_ptr<Asteroid>& a, float seconds) { a->Drift(seconds, size); };
+			for (int i = 0; i < N; ++i) {
+				std::unique_ptr<Asteroid> a = MakeAsteroid(SCREEN_W, SCREEN_H, AsteroidShape::RANDOM);
+				a->MoveBy({ Utils::RandomFloat(0, size.x - SCREEN_W), Utils::RandomFloat(0, size.y - SCREEN_H) });
+				a->Drift(0.f, size);
+				world.Sleep(std::move(a), 0.0, woken);
+			}
+			world.SetActive(world.SectorOf({ size.x * 0.5f, size.y * 0.5f }), 1, 0.0, drift, woken);
+			double now = 0.0;
+			double ns = Measure([&] { woken.clear(); }, [&] {
+				now += 1.0 / 60.0;
+				return world.Refresh(now, N / 60, drift, woken);
+			});
+			add("sector_refresh", "sleeper", ns);
+		}
+
+		if (enabled("flock")) {
+			// 5000 ships in a few overlapping swarms around a target, the game's per-tick work
+			constexpr int N = 5000;
+			Vector2 target{ 2000.f, 2000.f };
+			std::vector<EnemyShip> source;
+			source.reserve(N);
+			for (int i = 0; i < N; ++i) {
+				float ang = Utils::RandomFloat(0, 2 * PI);
+				float rad = Utils::RandomFloat(0, 900.f);
+				Vector2 p{ target.x + cosf(ang) * rad, target.y + sinf(ang) * rad };
+				source.emplace_back(p, Vector2{ Utils::RandomFloat(-90.f, 90.f), Utils::RandomFloat(-90.f, 90.f) }, i, false);
+			}
+			std::vector<EnemyShip> enemies = source;
+			FlockIndex index;
+			IndexEnemies(enemies, index);
+			// Let them bunch up first so the neighbour counts are realistic
+			for (uint32_t t = 0; t < 120; ++t) {
+				AdvanceEnemies(enemies, index, target, t, 1.f / 60.f, 0, N);
+				IndexEnemies(enemies, index);
+			}
+			const std::vector<EnemyShip> settled = enemies;
+			uint32_t tick = 0;
+			double ns = Measure([&] { enemies = settled; }, [&] {
+				AdvanceEnemies(enemies, index, target, tick++, 1.f / 60.f, 0, N);
+				IndexEnemies(enemies, index);
+				return N;
+			});
+			add("flock_tick_5000", "ship", ns);
+
+			ns = Measure([] {}, [&] {
+				for (int i = 0; i < N; ++i) {
+					FlockSums s = index.Query(settled[i].GetPosition(), EnemyShip::FLOCK.neighbourRadius, EnemyShip::FLOCK.separationRadius);
+					sink = sink + s.vx;
+				}
+				return N;
+			});
+			add("flock_query", "query", ns);
+		}
+
+		if (enabled("light_binning")) {
+			// 4000 projectile lights scattered over (and just off) the screen
+			constexpr int N = 4000;
+			LightTiles tiles;
+			tiles.Init(SCREEN_W, SCREEN_H);
+			std::vector<Light> lights;
+			for (int i = 0; i < N; ++i) {
+				float radius = i % 2 ? Weapon(WeaponType::LASER).lightRadius : Weapon(WeaponType::BULLET).lightRadius;
+				lights.push_back({ { Utils::RandomFloat(-100.f, SCREEN_W + 100.f), Utils::RandomFloat(-100.f, SCREEN_H + 100.f) }, radius });
+				tiles.Add(lights.back().p, radius, WHITE);
+			}
+			double ns = Measure([] {}, [&] {
+				tiles.Bin();
+				return N;
+			});
+			add("light_binning", "light", ns);
+			int bad = CheckLightTiles(tiles, lights);
+			if (bad) {
+				printf("light_binning: %d of %d tiles differ from the brute-force test\n", bad, tiles.Columns() * tiles.Rows());
+				failures++;
+			}
+		}
+
+		return results;
+	}
+
+	using BaselineRows = std::vector<std::pair<std::string, double>>;
+
+	// Baseline entries in file order
+	static BaselineRows ReadBaseline(const char* path) {
+		BaselineRows out;
+		FILE* f = fopen(path, "r");
+		if (!f) return out;
+		char line[256];
+		while (fgets(line, sizeof(line), f)) {
+			if (line[0] == '#' || line[0] == '\n') continue;
+			char name[128];
+			double ns = 0.0;
+			if (sscanf(line, "%127s %lf", name, &ns) == 2) out.emplace_back(name, ns);
+		}
+		fclose(f);
+		return out;
+	}
+
+	static std::map<std::string, double> LoadBaseline(const char* path) {
+		BaselineRows rows = ReadBaseline(path);
+		return { rows.begin(), rows.end() };
+	}
+
+	// With 'merge' (a --filter run) the kernels that ran replace their lines of the existing
+	// file and the others keep theirs; new kernels go at the end
+	static bool WriteBaseline(const char* path, const std::vector<Result>& results, bool merge) {
+		BaselineRows rows = merge ? ReadBaseline(path) : BaselineRows{};
+		for (const Result& r : results) {
+			auto it = std::find_if(rows.begin(), rows.end(), [&](const auto& row) { return row.first == r.name; });
+			if (it != rows.end()) it->second = r.nsPerUnit;
+			else rows.emplace_back(r.name, r.nsPerUnit);
+		}
+		FILE* f = fopen(path, "w");
+		if (!f) return false;
+		fprintf(f, "# name ns_per_unit (lower is better), written by Bench --write-baseline\n");
+		for (const auto& row : rows) fprintf(f, "%s %.3f\n", row.first.c_str(), row.second);
+		fclose(f);
+		return true;
+	}
+
+	// Returns the number of kernels that regressed past REGRESSION_LIMIT
+	static int Compare(const std::map<std::string, double>& baseline, const std::vector<Result>& results) {
+		int regressions = 0;
+		printf("\n%-32s %10s %10s %8s\n", "kernel", "baseline", "current", "delta");
+		for (const Result& r : results) {
+			auto it = baseline.find(r.name);
+			if (it == baseline.end()) {
+				printf("%-32s %10s %10.2f %8s\n", r.name.c_str(), "-", r.nsPerUnit, "new");
+				continue;
+			}
+			double delta = (r.nsPerUnit - it->second) / it->second;
+			bool bad = delta > REGRESSION_LIMIT;
+			regressions += bad;
+			printf("%-32s %10.2f %10.2f %+7.1f%%%s\n", r.name.c_str(), it->second, r.nsPerUnit, delta * 100.0,
+				bad ? "  REGRESSION" : "");
+		}
+		return regressions;
+	}
+}
+
+int main(int argc, char** argv) {
+	const char* baselinePath = nullptr;
+	const char* writePath = nullptr;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--baseline") && i + 1 < argc) baselinePath = argv[++i];
+		else if (!strcmp(argv[i], "--write-baseline") && i + 1 < argc) writePath = argv[++i];
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+		else {
+			printf("usage: %s [--baseline file] [--write-baseline file] [--filter text]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	SetTraceLogLevel(LOG_WARNING);
+	Utils::Rng().Seed(1234);
+	Renderer::Instance().InitHeadless(Bench::SCREEN_W, Bench::SCREEN_H);
+
+	std::vector<Bench::Result> results = Bench::Run(filter);
+
+	if (Bench::failures) {
+		printf("\n%d kernel(s) failed their check\n", Bench::failures);
+		return 1;
+	}
+	if (writePath && !Bench::WriteBaseline(writePath, results, filter != nullptr)) {
+		printf("could not write %s\n", writePath);
+		return 2;
+	}
+	if (baselinePath) {
+		auto baseline = Bench::LoadBaseline(baselinePath);
+		if (baseline.empty()) {
+			printf("no baseline in %s\n", baselinePath);
+			return 2;
+		}
+		int regressions = Bench::Compare(baseline, results);
+		if (regressions) {
+			printf("\n%d kernel(s) regressed by more than %.0f%%\n", regressions, Bench::REGRESSION_LIMIT * 100.0);
+			return 1;
+		}
+	}
+	return 0;
+}
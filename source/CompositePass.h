@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include <raylib.h>
+#include <rlgl.h>
+
+#include "LightTiles.h"
+
+// --- COMPOSITE PASS ---
+// The scene is drawn into a transparent render texture (premultiplied alpha). One
+// full-screen draw then puts it over the animated background and applies the boost
+// flash and pause dim, replacing the stacked ClearBackground/DrawRectangle fills.
+// The same pass adds the tiled projectile lights to scene and background; the HUD is
+// drawn after it and stays unlit.
+
+struct FrameOverlay {
+	float time = 0.f;
+	bool nightmare = false;
+	float flash = 0.f; // 0..1, white
+	float dim = 0.f;   // 0..1, black
+};
+
+class CompositePass {
+public:
+	// w x h screen units; the lights work in framebuffer pixels, see LightTiles::Init()
+	bool Load(int w, int h) {
+		width = w;
+		height = h;
+		renderHeight = GetRenderHeight();
+		scene = LoadRenderTexture(w, h);
+		std::string code = TextFormat("#version 330\n#define TILE %d\n#define TILE_SLOTS %d\n#define LIGHTS_PER_ROW %d\n",
+			LightTiles::TILE, LightTiles::TILE_SLOTS, LightTiles::LIGHTS_PER_ROW);
+		code += FS_CODE;
+		shader = LoadShaderFromMemory(nullptr, code.c_str());
+		if (shader.id == 0 || shader.id == rlGetShaderIdDefault()) {
+			shader = Shader{};
+			return false;
+		}
+		timeLoc = GetShaderLocation(shader, "time");
+		nightmareLoc = GetShaderLocation(shader, "nightmare");
+		flashLoc = GetShaderLocation(shader, "flash");
+		dimLoc = GetShaderLocation(shader, "dim");
+		lightsLoc = GetShaderLocation(shader, "lights");
+		tilesLoc = GetShaderLocation(shader, "lightTiles");
+		lightsOnLoc = GetShaderLocation(shader, "lightsOn");
+		heightLoc = GetShaderLocation(shader, "renderHeight");
+
+		int tileW = (GetRenderWidth() + LightTiles::TILE - 1) / LightTiles::TILE * LightTiles::TILE_SLOTS;
+		int tileH = (renderHeight + LightTiles::TILE - 1) / LightTiles::TILE;
+		lightTex = FloatTexture(LightTiles::LIGHT_TEXELS_W, LightTiles::LIGHT_ROWS, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+		tileTex = FloatTexture(tileW, tileH, PIXELFORMAT_UNCOMPRESSED_R32);
+		return true;
+	}
+
+	void Unload() {
+		if (scene.id != 0) UnloadRenderTexture(scene);
+		if (lightTex.id != 0) UnloadTexture(lightTex);
+		if (tileTex.id != 0) UnloadTexture(tileTex);
+		if (IsReady()) UnloadShader(shader);
+		scene = RenderTexture2D{};
+		lightTex = Texture2D{};
+		tileTex = Texture2D{};
+		shader = Shader{};
+	}
+
+	bool IsReady() const {
+		return shader.id != 0;
+	}
+
+	// Everything drawn until Composite() lands in the scene texture
+	void BeginScene() {
+		if (!IsReady()) return;
+		BeginTextureMode(scene);
+		ClearBackground(BLANK);
+		// Keep colour premultiplied and alpha correct so the composite can do "over" exactly
+		rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+		BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+	}
+
+	// Draws background + scene + overlays to the back buffer in one pass.
+	// Without the shader the scene was drawn straight to the back buffer, so only overlays are added.
+	void Composite(const FrameOverlay& ov, const LightTiles& lights) {
+		if (!IsReady()) {
+			if (ov.flash > 0.f) DrawRectangle(0, 0, width, height, Fade(WHITE, ov.flash));
+			if (ov.dim > 0.f) DrawRectangle(0, 0, width, height, Fade(BLACK, ov.dim));
+			return;
+		}
+
+		EndBlendMode();
+		EndTextureMode();
+
+		float time = ov.time;
+		float nightmare = ov.nightmare ? 1.f : 0.f;
+		SetShaderValue(shader, timeLoc, &time, SHADER_UNIFORM_FLOAT);
+		SetShaderValue(shader, nightmareLoc, &nightmare, SHADER_UNIFORM_FLOAT);
+		SetShaderValue(shader, flashLoc, &ov.flash, SHADER_UNIFORM_FLOAT);
+		SetShaderValue(shader, dimLoc, &ov.dim, SHADER_UNIFORM_FLOAT);
+
+		// Only the rows of the light texture that hold lights are uploaded
+		float lightsOn = 0.f;
+		if (lights.Count() > 0 && lightTex.id != 0 && tileTex.id != 0) {
+			UpdateTextureRec(lightTex, { 0, 0, static_cast<float>(LightTiles::LIGHT_TEXELS_W), static_cast<float>(lights.LightRowsUsed()) }, lights.LightData());
+			UpdateTexture(tileTex, lights.TileData());
+			lightsOn = 1.f;
+		}
+		float pixelsHigh = static_cast<float>(renderHeight);
+		SetShaderValue(shader, lightsOnLoc, &lightsOn, SHADER_UNIFORM_FLOAT);
+		SetShaderValue(shader, heightLoc, &pixelsHigh, SHADER_UNIFORM_FLOAT);
+
+		BeginShaderMode(shader);
+		// Extra texture units are bound with the next batch draw; switching shaders flushes
+		// and resets them, so these go after BeginShaderMode
+		SetShaderValueTexture(shader, lightsLoc, lightTex);
+		SetShaderValueTexture(shader, tilesLoc, tileTex);
+		// Render textures are stored upside down
+		DrawTextureRec(scene.texture, { 0, 0, static_cast<float>(width), -static_cast<float>(height) }, { 0, 0 }, WHITE);
+		EndShaderMode();
+	}
+
+	// Background colour the shader produces, for the fallback path
+	static Color BackgroundColor(float time, bool nightmare) {
+		if (nightmare) {
+			float flashAlpha = (sinf(time * 10) * 0.5f + 0.5f) * 0.3f;
+			return ColorAlphaBlend(DARKGRAY, Fade(RED, flashAlpha), WHITE);
+		}
+		float t = time * 0.5f;
+		return {
+			(unsigned char)(150 + 50 * sinf(t)),
+			(unsigned char)(200 + 50 * sinf(t + 2)),
+			(unsigned char)(230 + 25 * sinf(t + 4)),
+			255
+		};
+	}
+
+private:
+	static Texture2D FloatTexture(int w, int h, int format) {
+		Texture2D t{};
+		t.id = rlLoadTexture(nullptr, w, h, format, 1);
+		if (t.id == 0) return t;
+		t.width = w;
+		t.height = h;
+		t.mipmaps = 1;
+		t.format = format;
+		return t;
+	}
+
+	int width = 0;
+	int height = 0;
+	int renderHeight = 0; // framebuffer pixels, gl_FragCoord's units
+	RenderTexture2D scene{};
+	Shader shader{};
+	int timeLoc = -1;
+	int nightmareLoc = -1;
+	int flashLoc = -1;
+	int dimLoc = -1;
+	int lightsLoc = -1;
+	int tilesLoc = -1;
+	int lightsOnLoc = -1;
+	int heightLoc = -1;
+	Texture2D lightTex{};
+	Texture2D tileTex{};
+
+	// Compiled after a header with #version and the LightTiles layout constants
+	inline static const char* FS_CODE = R"(
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+uniform sampler2D texture0;
+uniform float time;
+uniform float nightmare;
+uniform float flash;
+uniform float dim;
+uniform sampler2D lights;     // see LightTiles.h
+uniform sampler2D lightTiles;
+uniform float lightsOn;
+uniform float renderHeight;
+
+out vec4 finalColor;
+
+const vec3 DARKGRAY = vec3(80.0, 80.0, 80.0) / 255.0;
+const vec3 RED = vec3(230.0, 41.0, 55.0) / 255.0;
+
+// Sum of the lights listed for the tile p is in, p in framebuffer pixels
+vec3 TileLight(vec2 p) {
+	ivec2 tile = ivec2(p) / TILE;
+	int base = tile.x * TILE_SLOTS;
+	int count = int(texelFetch(lightTiles, ivec2(base, tile.y), 0).r);
+	vec3 sum = vec3(0.0);
+	for (int i = 1; i <= count; ++i) {
+		int index = int(texelFetch(lightTiles, ivec2(base + i, tile.y), 0).r);
+		ivec2 at = ivec2((index % LIGHTS_PER_ROW) * 2, index / LIGHTS_PER_ROW);
+		vec4 l = texelFetch(lights, at, 0);
+		float falloff = clamp(1.0 - length(p - l.xy) / l.z, 0.0, 1.0);
+		sum += texelFetch(lights, at + ivec2(1, 0), 0).rgb * falloff * falloff;
+	}
+	return sum;
+}
+
+void main() {
+	vec3 bg;
+	if (nightmare > 0.5) {
+		float pulse = (sin(time * 10.0) * 0.5 + 0.5) * 0.3;
+		bg = mix(DARKGRAY, RED, pulse);
+	}
+	else {
+		float t = time * 0.5;
+		bg = vec3(150.0 + 50.0 * sin(t), 200.0 + 50.0 * sin(t + 2.0), 230.0 + 25.0 * sin(t + 4.0)) / 255.0;
+	}
+
+	vec4 scene = texture(texture0, fragTexCoord); // premultiplied
+	vec3 color = scene.rgb + bg * (1.0 - scene.a);
+	if (lightsOn > 0.5) {
+		// Saturates softly, dozens of overlapping shots should not burn out to white
+		vec3 light = 1.0 - exp(-0.5 * TileLight(vec2(gl_FragCoord.x, renderHeight - gl_FragCoord.y)));
+		color = color * (1.0 + light) + light * 0.2;
+	}
+	color = mix(color, vec3(1.0), flash);
+	color *= 1.0 - dim;
+	finalColor = vec4(color, 1.0);
+}
+)";
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cmath>
+
+#include <raylib.h>
+
+// Requires SUPPORT_CUSTOM_FRAME_CONTROL in raylib's config.h: EndDrawing() then
+// no longer swaps, waits or polls input, the pacer does it instead.
+
+// --- LATENCY HISTOGRAM ---
+class LatencyHistogram {
+public:
+	static constexpr double BUCKET_MS = 0.25;
+	static constexpr int BUCKETS = 200; // 0..50 ms, last bucket is overflow
+
+	void Record(double seconds) {
+		double ms = seconds * 1000.0;
+		int b = static_cast<int>(ms / BUCKET_MS);
+		if (b < 0) b = 0;
+		if (b >= BUCKETS) b = BUCKETS - 1;
+		buckets[b]++;
+		count++;
+		sumMs += ms;
+		if (ms > maxMs) maxMs = ms;
+	}
+
+	void Reset() {
+		buckets.fill(0);
+		count = 0;
+		sumMs = 0.0;
+		maxMs = 0.0;
+	}
+
+	// Upper edge of the bucket holding the p-th percentile (p in 0..1)
+	double PercentileMs(double p) const {
+		if (count == 0) return 0.0;
+		uint64_t rank = static_cast<uint64_t>(ceil(p * static_cast<double>(count)));
+		if (rank == 0) rank = 1;
+		uint64_t seen = 0;
+		for (int i = 0; i < BUCKETS; ++i) {
+			seen += buckets[i];
+			if (seen >= rank) return (i + 1) * BUCKET_MS;
+		}
+		return maxMs;
+	}
+
+	double MeanMs() const { return count ? sumMs / static_cast<double>(count) : 0.0; }
+	double MaxMs() const { return maxMs; }
+	uint64_t Count() const { return count; }
+	uint64_t Bucket(int i) const { return buckets[i]; }
+
+private:
+	std::array<uint64_t, BUCKETS> buckets{};
+	uint64_t count = 0;
+	double sumMs = 0.0;
+	double maxMs = 0.0;
+};
+
+// --- FRAME PACER ---
+enum class PacingMode { UNCAPPED, FIXED_CAP, JUST_IN_TIME, COUNT };
+
+inline const char* PacingModeName(PacingMode m) {
+	switch (m) {
+	case PacingMode::UNCAPPED: return "UNCAPPED";
+	case PacingMode::FIXED_CAP: return "FIXED CAP";
+	case PacingMode::JUST_IN_TIME: return "JUST IN TIME";
+	default: return "?";
+	}
+}
+
+// Frame layout: [wait] -> PollInputEvents -> simulate -> draw -> SwapScreenBuffer.
+// Waiting happens before input is polled, so the input used by a frame is as
+// fresh as the pacing mode allows.
+class FramePacer {
+public:
+	void Init(PacingMode m, int fps) {
+		mode = m;
+		SetTargetFPS(fps);
+		lastPoll = GetTime();
+		lastPresent = lastPoll;
+		nextPresent = lastPoll + period;
+		workEstimate = period * 0.5;
+	}
+
+	void SetTargetFPS(int fps) {
+		targetFps = fps > 0 ? fps : 60;
+		period = 1.0 / targetFps;
+	}
+
+	void SetMode(PacingMode m) {
+		mode = m;
+		latency.Reset();
+		nextPresent = GetTime() + period;
+	}
+
+	void CycleMode() {
+		SetMode(static_cast<PacingMode>((static_cast<int>(mode) + 1) % static_cast<int>(PacingMode::COUNT)));
+	}
+
+	// Waits according to the pacing mode, polls input and returns the frame delta.
+	float BeginFrame() {
+		double now = GetTime();
+		switch (mode) {
+		case PacingMode::FIXED_CAP: {
+			double deadline = lastPoll + period;
+			if (now < deadline) WaitTime(deadline - now);
+		} break;
+		case PacingMode::JUST_IN_TIME: {
+			// Start as late as possible so that work finishes right at the next present slot
+			while (nextPresent < now) nextPresent += period;
+			double start = nextPresent - workEstimate * JIT_SAFETY - JIT_MARGIN;
+			if (now < start) WaitTime(start - now);
+		} break;
+		default:
+			break;
+		}
+
+		PollInputEvents();
+		inputTime = GetTime();
+		lastFrame = inputTime - lastPoll;
+		lastPoll = inputTime;
+		float dt = static_cast<float>(lastFrame);
+		return dt < MAX_DT ? dt : MAX_DT;
+	}
+
+	// Presents the frame drawn since BeginFrame() and records input-to-present latency.
+	void EndFrame() {
+		SwapScreenBuffer();
+		double now = GetTime();
+		double work = now - inputTime;
+		latency.Record(work);
+		workEstimate += (work - workEstimate) * WORK_SMOOTHING;
+		if (work > workEstimate) workEstimate = work; // react to spikes immediately, decay slowly
+		lastPresent = now;
+		if (mode == PacingMode::JUST_IN_TIME) nextPresent += period;
+	}
+
+	PacingMode Mode() const { return mode; }
+	int TargetFPS() const { return targetFps; }
+	double Period() const { return period; }
+	// Poll to poll time of the frame before this one, not clamped like BeginFrame()'s dt
+	double LastFrameSeconds() const { return lastFrame; }
+	const LatencyHistogram& Latency() const { return latency; }
+
+private:
+	static constexpr double JIT_SAFETY = 1.5;
+	static constexpr double JIT_MARGIN = 0.001;
+	static constexpr double WORK_SMOOTHING = 0.05;
+	static constexpr float MAX_DT = 0.1f;
+
+	PacingMode mode = PacingMode::FIXED_CAP;
+	int targetFps = 60;
+	double period = 1.0 / 60.0;
+	double lastPoll = 0.0;
+	double lastPresent = 0.0;
+	double nextPresent = 0.0;
+	double inputTime = 0.0;
+	double lastFrame = 0.0;
+	double workEstimate = 0.0;
+	LatencyHistogram latency;
+};
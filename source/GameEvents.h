@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// --- GAMEPLAY EVENTS ---
+// Detection phases only read entity state and append events. Resolve() applies them
+// once per tick in a fixed order, independent of how many workers produced them.
+
+// Declaration order is the resolve order. Hearts heal before hits land, as the old
+// per-entity loops did, so a pickup in the same tick can save the player.
+enum class GameEventType : uint8_t {
+	BOOST_FIRED,        // -
+	ASTEROID_DESTROYED, // a = projectile, b = asteroid, value = score
+	ENEMY_DESTROYED,    // a = projectile, b = enemy, value = score
+	HEART_COLLECTED,    // a = heart, value = max heal
+	PLAYER_HIT,         // kind, a = asteroid or enemy, value = damage
+	ENTITY_EXPIRED,     // kind, a = entity
+	COUNT
+};
+
+enum class EntityKind : uint8_t { NONE, ASTEROID, PROJECTILE, HEART, ENEMY };
+
+struct GameEvent {
+	GameEventType type;
+	EntityKind kind;
+	uint32_t a;
+	uint32_t b;
+	int value;
+};
+
+inline const char* GameEventName(GameEventType t) {
+	switch (t) {
+	case GameEventType::BOOST_FIRED: return "BoostFired";
+	case GameEventType::ASTEROID_DESTROYED: return "AsteroidDestroyed";
+	case GameEventType::ENEMY_DESTROYED: return "EnemyDestroyed";
+	case GameEventType::HEART_COLLECTED: return "HeartCollected";
+	case GameEventType::PLAYER_HIT: return "PlayerHit";
+	case GameEventType::ENTITY_EXPIRED: return "EntityExpired";
+	default: return "?";
+	}
+}
+
+class EventBuffer {
+public:
+	void Push(GameEventType type, uint32_t a, uint32_t b = 0, int value = 0, EntityKind kind = EntityKind::NONE) {
+		events.push_back({ type, kind, a, b, value });
+	}
+
+	void Clear() { events.clear(); }
+	bool Empty() const { return events.empty(); }
+	const std::vector<GameEvent>& Events() const { return events; }
+
+private:
+	std::vector<GameEvent> events;
+};
+
+class EventQueue {
+public:
+	static constexpr int TYPES = static_cast<int>(GameEventType::COUNT);
+
+	// One buffer per worker, a worker only ever touches its own
+	EventBuffer& Buffer(int worker) {
+		if (worker >= static_cast<int>(buffers.size())) buffers.resize(worker + 1);
+		return buffers[worker];
+	}
+
+	void Reserve(int workers) {
+		if (workers > static_cast<int>(buffers.size())) buffers.resize(workers);
+	}
+
+	// Merges all buffers, sorts by (type, kind, a, b) and calls apply(event) for each.
+	// Buffers are cleared afterwards.
+	template<typename Apply>
+	void Resolve(Apply&& apply) {
+		merged.clear();
+		for (auto& b : buffers) {
+			merged.insert(merged.end(), b.Events().begin(), b.Events().end());
+			b.Clear();
+		}
+		std::sort(merged.begin(), merged.end(), [](const GameEvent& l, const GameEvent& r) {
+			if (l.type != r.type) return l.type < r.type;
+			if (l.kind != r.kind) return l.kind < r.kind;
+			if (l.a != r.a) return l.a < r.a;
+			return l.b < r.b;
+		});
+
+		tickCounts.fill(0);
+		for (const GameEvent& e : merged) {
+			tickCounts[static_cast<int>(e.type)]++;
+			apply(e);
+		}
+		for (int i = 0; i < TYPES; ++i) totalCounts[i] += tickCounts[i];
+	}
+
+	// Events produced during the last resolved tick, including ones that turned out stale
+	uint32_t TickCount(GameEventType t) const { return tickCounts[static_cast<int>(t)]; }
+	uint64_t TotalCount(GameEventType t) const { return totalCounts[static_cast<int>(t)]; }
+
+	// Drops pending events without resolving them
+	void Discard() {
+		for (auto& b : buffers) b.Clear();
+	}
+
+	void ResetCounts() {
+		tickCounts.fill(0);
+		totalCounts.fill(0);
+	}
+
+private:
+	std::vector<EventBuffer> buffers;
+	std::vector<GameEvent> merged;
+	std::array<uint32_t, TYPES> tickCounts{};
+	std::array<uint64_t, TYPES> totalCounts{};
+};
+
+// Removes every element whose flag is set, keeping the order of the rest
+template<typename T>
+void CompactByFlags(std::vector<T>& items, const std::vector<uint8_t>& dead) {
+	size_t out = 0;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (dead[i]) continue;
+		if (out != i) items[out] = std::move(items[i]);
+		++out;
+	}
+	items.erase(items.begin() + out, items.end());
+}
+
+// Stable entity handles over vectors that reorder on removal. A handle packs a slot
+// (low 20 bits) and that slot's generation, so handles to removed entities go stale.
+class HandleMap {
+public:
+	static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+	uint32_t Acquire(uint32_t index) {
+		uint32_t slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			slot = static_cast<uint32_t>(indices.size());
+			indices.push_back(INVALID);
+			generations.push_back(0);
+		}
+		indices[slot] = index;
+		return slot | (generations[slot] << SLOT_BITS);
+	}
+
+	void Release(uint32_t handle) {
+		uint32_t slot = handle & SLOT_MASK;
+		if (!IsValid(handle)) return;
+		indices[slot] = INVALID;
+		generations[slot] = (generations[slot] + 1) & GEN_MASK;
+		freeSlots.push_back(slot);
+	}
+
+	// The entity behind a valid handle now lives at 'index'
+	void Move(uint32_t handle, uint32_t index) {
+		indices[handle & SLOT_MASK] = index;
+	}
+
+	bool IsValid(uint32_t handle) const {
+		uint32_t slot = handle & SLOT_MASK;
+		return slot < indices.size() && indices[slot] != INVALID && generations[slot] == (handle >> SLOT_BITS);
+	}
+
+	// Current index or INVALID for a stale handle
+	uint32_t Index(uint32_t handle) const {
+		return IsValid(handle) ? indices[handle & SLOT_MASK] : INVALID;
+	}
+
+	void Clear() {
+		freeSlots.clear();
+		for (uint32_t slot = 0; slot < indices.size(); ++slot) {
+			if (indices[slot] != INVALID) generations[slot] = (generations[slot] + 1) & GEN_MASK;
+			indices[slot] = INVALID;
+			freeSlots.push_back(slot);
+		}
+	}
+
+private:
+	static constexpr uint32_t SLOT_BITS = 20;
+	static constexpr uint32_t SLOT_MASK = (1u << SLOT_BITS) - 1;
+	static constexpr uint32_t GEN_MASK = (1u << (32 - SLOT_BITS)) - 1;
+
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> generations;
+	std::vector<uint32_t> freeSlots;
+};
+
+// CompactByFlags that also keeps 'handles' pointing at the moved survivors and
+// releases the handles of removed items. removed(item, index) may take a removed item
+// over (e.g. move it somewhere else) once its handle is released.
+template<typename T, typename HandleOf, typename Removed>
+void CompactByFlags(std::vector<T>& items, const std::vector<uint8_t>& dead, HandleMap& handles, HandleOf&& handleOf,
+	Removed&& removed)
+{
+	size_t out = 0;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (dead[i]) {
+			handles.Release(handleOf(items[i]));
+			removed(items[i], i);
+			continue;
+		}
+		if (out != i) {
+			items[out] = std::move(items[i]);
+			handles.Move(handleOf(items[out]), static_cast<uint32_t>(out));
+		}
+		++out;
+	}
+	items.erase(items.begin() + out, items.end());
+}
+
+template<typename T, typename HandleOf>
+void CompactByFlags(std::vector<T>& items, const std::vector<uint8_t>& dead, HandleMap& handles, HandleOf&& handleOf) {
+	CompactByFlags(items, dead, handles, handleOf, [](T&, size_t) {});
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <raylib.h>
+
+#include "FramePacing.h"
+#include "Input.h"
+
+// --- HITCH DETECTOR ---
+// Keeps a ring of per-frame records (input, RNG state, phase timings, entity counts) and
+// the input of every frame since the last replay point (session start or restart).
+// When a frame runs over budget, everything needed to replay up to that frame is dumped
+// to a capture file; "Main --replay file" plays it back and compares the timings.
+// Captures are only valid for the build that wrote them.
+
+enum class FramePhase : uint8_t { UPDATE, SIMULATE, RESOLVE, RENDER, PRESENT, COUNT };
+static constexpr int FRAME_PHASES = static_cast<int>(FramePhase::COUNT);
+
+inline const char* FramePhaseName(FramePhase p) {
+	switch (p) {
+	case FramePhase::UPDATE: return "update";
+	case FramePhase::SIMULATE: return "simulate";
+	case FramePhase::RESOLVE: return "resolve";
+	case FramePhase::RENDER: return "render";
+	case FramePhase::PRESENT: return "present";
+	default: return "?";
+	}
+}
+
+struct FrameRecord {
+	uint32_t frame;    // since the replay point
+	float frameMs;     // poll to poll, known once the next frame starts
+	InputFrame input;
+	uint64_t rngState; // before the frame ran
+	float phaseMs[FRAME_PHASES];
+	uint32_t asteroids;
+	uint32_t projectiles;
+	uint32_t hearts;
+};
+
+// On-disk capture: header, inputs[inputCount], records[recordCount], histogram[buckets]
+struct HitchCapture {
+	static constexpr uint32_t MAGIC = 0x54494855; // "UHIT"
+	static constexpr uint32_t VERSION = 2;
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t replayRng;    // RNG state at the replay point
+		uint32_t replayConfig; // game settings the replay point depends on, see BeginSegment()
+		uint32_t inputCount;   // 0 if the replay log overflowed
+		uint32_t recordCount;  // the last record is the hitch
+		float budgetMs;
+		uint32_t histogramBuckets;
+		float histogramBucketMs;
+		uint32_t recordSize;
+	};
+
+	Header header{};
+	std::vector<InputFrame> inputs;
+	std::vector<FrameRecord> records;
+	std::vector<uint64_t> histogram;
+
+	bool Save(const char* path) const {
+		std::vector<unsigned char> bytes;
+		Append(bytes, &header, sizeof(header));
+		Append(bytes, inputs.data(), inputs.size() * sizeof(InputFrame));
+		Append(bytes, records.data(), records.size() * sizeof(FrameRecord));
+		Append(bytes, histogram.data(), histogram.size() * sizeof(uint64_t));
+		return SaveFileData(path, bytes.data(), static_cast<int>(bytes.size()));
+	}
+
+	bool Load(const char* path) {
+		int size = 0;
+		unsigned char* data = LoadFileData(path, &size);
+		if (!data) return false;
+		size_t offset = 0;
+		bool ok = Read(data, size, offset, &header, sizeof(header)) && header.magic == MAGIC &&
+			header.version == VERSION && header.recordSize == sizeof(FrameRecord);
+		if (ok) {
+			inputs.resize(header.inputCount);
+			records.resize(header.recordCount);
+			histogram.resize(header.histogramBuckets);
+			ok = Read(data, size, offset, inputs.data(), inputs.size() * sizeof(InputFrame)) &&
+				Read(data, size, offset, records.data(), records.size() * sizeof(FrameRecord)) &&
+				Read(data, size, offset, histogram.data(), histogram.size() * sizeof(uint64_t));
+		}
+		UnloadFileData(data);
+		return ok;
+	}
+
+private:
+	static void Append(std::vector<unsigned char>& out, const void* src, size_t n) {
+		const unsigned char* p = static_cast<const unsigned char*>(src);
+		out.insert(out.end(), p, p + n);
+	}
+
+	static bool Read(const unsigned char* data, int size, size_t& offset, void* dst, size_t n) {
+		if (offset + n > static_cast<size_t>(size)) return false;
+		memcpy(dst, data + offset, n);
+		offset += n;
+		return true;
+	}
+};
+
+class HitchDetector {
+public:
+	static constexpr int RING_FRAMES = 4096;
+	static constexpr float CAPTURE_SECONDS = 5.f; // of detailed records before the hitch
+	static constexpr uint32_t MAX_REPLAY_FRAMES = 60 * 60 * 30; // 30 min at 60 Hz, ~1.3 MB
+	static constexpr int WARMUP_FRAMES = 30;
+	static constexpr float CAPTURE_COOLDOWN = 5.f; // writing a capture is itself a long frame
+	static constexpr int MAX_CAPTURES = 10;
+
+	void Init(double budgetSeconds, bool captureEnabled, uint32_t sessionId) {
+		budget = budgetSeconds;
+		capture = captureEnabled;
+		session = sessionId;
+	}
+
+	// Frames replay from here: call with the RNG state the next frame starts with, and
+	// whatever else the game needs to rebuild the same starting state
+	void BeginSegment(uint64_t rngState, uint32_t config) {
+		replayRng = rngState;
+		replayConfig = config;
+		replayInputs.clear();
+		replayOverflow = false;
+		segmentFrame = 0;
+	}
+
+	// Right after input polling. Finishes the previous frame with its full length and
+	// dumps a capture if it went over budget.
+	void BeginFrame(double lastFrameSeconds, const InputFrame& input, uint64_t rngState) {
+		if (open) {
+			FrameRecord& prev = ring[(head + RING_FRAMES - 1) % RING_FRAMES];
+			prev.frameMs = static_cast<float>(lastFrameSeconds * 1000.0);
+			if (++framesSeen > WARMUP_FRAMES) {
+				frameTimes.Record(lastFrameSeconds);
+				sinceCapture += static_cast<float>(lastFrameSeconds);
+				if (lastFrameSeconds > budget) {
+					hitches++;
+					if (capture && captures < MAX_CAPTURES && sinceCapture > CAPTURE_COOLDOWN) {
+						WriteCapture();
+						sinceCapture = 0.f;
+					}
+				}
+			}
+		}
+
+		FrameRecord& r = ring[head];
+		r = FrameRecord{};
+		r.frame = segmentFrame++;
+		r.input = input;
+		r.rngState = rngState;
+		head = (head + 1) % RING_FRAMES;
+		if (stored < RING_FRAMES) stored++;
+		open = true;
+
+		if (replayInputs.size() < MAX_REPLAY_FRAMES) replayInputs.push_back(input);
+		else replayOverflow = true;
+
+		markTime = GetTime();
+	}
+
+	// Attributes the time since the last mark to 'phase'
+	void Mark(FramePhase phase) {
+		double now = GetTime();
+		Current().phaseMs[static_cast<int>(phase)] += static_cast<float>((now - markTime) * 1000.0);
+		markTime = now;
+	}
+
+	void SetCounts(size_t asteroids, size_t projectiles, size_t hearts) {
+		FrameRecord& r = Current();
+		r.asteroids = static_cast<uint32_t>(asteroids);
+		r.projectiles = static_cast<uint32_t>(projectiles);
+		r.hearts = static_cast<uint32_t>(hearts);
+	}
+
+	// Latest record with the given frame number, nullptr if it left the ring
+	const FrameRecord* Find(uint32_t frame) const {
+		for (int i = 1; i <= stored; ++i) {
+			const FrameRecord& r = ring[(head + RING_FRAMES - i) % RING_FRAMES];
+			if (r.frame == frame) return &r;
+			if (r.frame < frame) break;
+		}
+		return nullptr;
+	}
+
+	const LatencyHistogram& FrameTimes() const { return frameTimes; }
+	int Hitches() const { return hitches; }
+	int Captures() const { return captures; }
+	double BudgetMs() const { return budget * 1000.0; }
+
+	// Frame time histogram of the whole session as text, one non-empty bucket per line
+	bool WriteHistogram(const char* path) const {
+		std::string text = TextFormat("# frame time histogram, %llu frames, p50 %.2f ms, p99 %.2f ms, max %.2f ms, %d over %.2f ms\n",
+			(unsigned long long)frameTimes.Count(), frameTimes.PercentileMs(0.5), frameTimes.PercentileMs(0.99),
+			frameTimes.MaxMs(), hitches, BudgetMs());
+		text += "# upper_ms count\n";
+		for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+			if (frameTimes.Bucket(i) == 0) continue;
+			text += TextFormat("%.2f %llu\n", (i + 1) * LatencyHistogram::BUCKET_MS, (unsigned long long)frameTimes.Bucket(i));
+		}
+		return SaveFileText(path, const_cast<char*>(text.c_str()));
+	}
+
+private:
+	FrameRecord& Current() {
+		return ring[(head + RING_FRAMES - 1) % RING_FRAMES];
+	}
+
+	// The frame that just finished is the hitch; the one in progress is not included
+	void WriteCapture() {
+		HitchCapture c;
+		c.header.magic = HitchCapture::MAGIC;
+		c.header.version = HitchCapture::VERSION;
+		c.header.replayRng = replayRng;
+		c.header.replayConfig = replayConfig;
+		c.header.budgetMs = static_cast<float>(BudgetMs());
+		c.header.recordSize = sizeof(FrameRecord);
+		if (!replayOverflow) c.inputs = replayInputs;
+
+		// Walk back from the hitch until CAPTURE_SECONDS are covered or the segment starts
+		float covered = 0.f;
+		int count = 0;
+		while (count < stored && covered < CAPTURE_SECONDS * 1000.f) {
+			const FrameRecord& r = ring[(head + RING_FRAMES - 1 - count) % RING_FRAMES];
+			count++;
+			covered += r.frameMs;
+			if (r.frame == 0) break;
+		}
+		for (int i = count; i >= 1; --i) c.records.push_back(ring[(head + RING_FRAMES - i) % RING_FRAMES]);
+		c.header.inputCount = static_cast<uint32_t>(c.inputs.size());
+		c.header.recordCount = static_cast<uint32_t>(c.records.size());
+
+		c.header.histogramBuckets = LatencyHistogram::BUCKETS;
+		c.header.histogramBucketMs = static_cast<float>(LatencyHistogram::BUCKET_MS);
+		for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) c.histogram.push_back(frameTimes.Bucket(i));
+
+		const char* path = TextFormat("hitch_%u_%02d.bin", session, captures);
+		if (c.Save(path)) {
+			captures++;
+			TraceLog(LOG_WARNING, "HITCH: %.2f ms frame (budget %.2f ms), capture written to %s",
+				c.records.back().frameMs, BudgetMs(), path);
+		}
+	}
+
+	std::array<FrameRecord, RING_FRAMES> ring{};
+	int head = 0;
+	int stored = 0;
+	bool open = false;
+	uint32_t segmentFrame = 0;
+	double markTime = 0.0;
+
+	uint64_t replayRng = 0;
+	uint32_t replayConfig = 0;
+	std::vector<InputFrame> replayInputs;
+	bool replayOverflow = false;
+
+	double budget = 1.0 / 30.0;
+	bool capture = true;
+	uint32_t session = 0;
+	uint64_t framesSeen = 0;
+	float sinceCapture = CAPTURE_COOLDOWN;
+	int hitches = 0;
+	int captures = 0;
+	LatencyHistogram frameTimes;
+};
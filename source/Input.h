@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+#include <raylib.h>
+
+// --- INPUT ---
+// Everything the game reads from the keyboard in one frame. The simulation only ever
+// looks at an InputFrame, so recorded frames replay exactly (see HitchDetector.h).
+
+enum InputButton : uint32_t {
+	BTN_UP = 1u << 0,
+	BTN_DOWN = 1u << 1,
+	BTN_LEFT = 1u << 2,
+	BTN_RIGHT = 1u << 3,
+	BTN_FIRE = 1u << 4,
+	BTN_BOOST = 1u << 5,
+	BTN_RESTART = 1u << 6,
+	BTN_WEAPON = 1u << 7,
+	BTN_SHAPE_1 = 1u << 8,
+	BTN_SHAPE_2 = 1u << 9,
+	BTN_SHAPE_3 = 1u << 10,
+	BTN_SHAPE_4 = 1u << 11,
+	BTN_PAUSE = 1u << 12,
+	BTN_PACING = 1u << 13,
+	BTN_OVERLAY = 1u << 14,
+	BTN_SDF = 1u << 15,
+	BTN_CAPTURE = 1u << 16,
+	BTN_MOD_CTRL = 1u << 17,
+	BTN_MOD_SHIFT = 1u << 18,
+	BTN_SORT = 1u << 19,
+};
+
+struct InputFrame {
+	float dt = 0.f;
+	uint32_t down = 0;    // held this frame
+	uint32_t pressed = 0; // went down this frame
+
+	bool Down(InputButton b) const { return (down & b) != 0; }
+	bool Pressed(InputButton b) const { return (pressed & b) != 0; }
+};
+
+// Call after PollInputEvents()
+inline InputFrame ReadInput(float dt) {
+	struct Binding {
+		InputButton button;
+		int key;
+	};
+	static constexpr Binding BINDINGS[] = {
+		{ BTN_UP, KEY_W }, { BTN_DOWN, KEY_S }, { BTN_LEFT, KEY_A }, { BTN_RIGHT, KEY_D },
+		{ BTN_FIRE, KEY_SPACE }, { BTN_BOOST, KEY_J }, { BTN_RESTART, KEY_R }, { BTN_WEAPON, KEY_TAB },
+		{ BTN_SHAPE_1, KEY_ONE }, { BTN_SHAPE_2, KEY_TWO }, { BTN_SHAPE_3, KEY_THREE }, { BTN_SHAPE_4, KEY_FOUR },
+		{ BTN_PAUSE, KEY_P }, { BTN_PACING, KEY_F2 }, { BTN_OVERLAY, KEY_F3 }, { BTN_SDF, KEY_F4 },
+		{ BTN_CAPTURE, KEY_F12 }, { BTN_MOD_CTRL, KEY_LEFT_CONTROL }, { BTN_MOD_SHIFT, KEY_LEFT_SHIFT },
+		{ BTN_SORT, KEY_F5 },
+	};
+
+	InputFrame in;
+	in.dt = dt;
+	for (const Binding& b : BINDINGS) {
+		if (IsKeyDown(b.key)) in.down |= b.button;
+		if (IsKeyPressed(b.key)) in.pressed |= b.button;
+	}
+	return in;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --- JOB POOL ---
+// Persistent worker threads for data-parallel loops. The calling thread takes part
+// in every ParallelFor, so worker index 0 is always the caller.
+class JobPool {
+public:
+	static JobPool& Instance() {
+		static JobPool inst;
+		return inst;
+	}
+
+	~JobPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (auto& t : threads) t.join();
+	}
+
+	// Total worker count including the calling thread
+	int Workers() const {
+		return static_cast<int>(threads.size()) + 1;
+	}
+
+	// Splits [0, count) into chunks of at least minChunk and calls fn(begin, end, worker).
+	// Returns once every chunk is done. Not reentrant.
+	template<typename Fn>
+	void ParallelFor(int count, int minChunk, Fn&& fn) {
+		if (count <= 0) return;
+		int chunks = std::min(Workers(), (count + minChunk - 1) / std::max(minChunk, 1));
+		if (chunks <= 1) {
+			fn(0, count, 0);
+			return;
+		}
+
+		int chunkSize = (count + chunks - 1) / chunks;
+		job = [&fn, count, chunkSize](int chunk, int worker) {
+			int begin = chunk * chunkSize;
+			int end = std::min(count, begin + chunkSize);
+			if (begin < end) fn(begin, end, worker);
+		};
+		chunkCount.store(chunks);
+		pending.store(chunks);
+		nextChunk.store(0); // publish last: workers that wake late only see a fully set up job
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			generation++;
+		}
+		wake.notify_all();
+
+		RunChunks(0);
+		while (pending.load(std::memory_order_acquire) > 0) {
+			std::this_thread::yield();
+		}
+		nextChunk.store(CLOSED);
+		job = nullptr;
+	}
+
+private:
+	JobPool() {
+		unsigned hw = std::thread::hardware_concurrency();
+		int extra = hw > 1 ? static_cast<int>(std::min(hw, MAX_THREADS)) - 1 : 0;
+		for (int i = 0; i < extra; ++i) {
+			threads.emplace_back([this, i] { WorkerLoop(i + 1); });
+		}
+	}
+
+	void WorkerLoop(int worker) {
+		unsigned seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return quit || generation != seen; });
+				if (quit) return;
+				seen = generation;
+			}
+			RunChunks(worker);
+		}
+	}
+
+	void RunChunks(int worker) {
+		for (;;) {
+			int chunk = nextChunk.fetch_add(1);
+			if (chunk >= chunkCount.load()) return;
+			job(chunk, worker);
+			pending.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	static constexpr unsigned MAX_THREADS = 16;
+	static constexpr int CLOSED = 1 << 30;
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool quit = false;
+	unsigned generation = 0;
+
+	std::function<void(int, int)> job;
+	std::atomic<int> nextChunk{ CLOSED };
+	std::atomic<int> pending{ 0 };
+	std::atomic<int> chunkCount{ 0 };
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <raylib.h>
+
+#include "Jobs.h"
+
+// --- TILED LIGHTS ---
+// Point lights binned into TILE x TILE screen tiles on the CPU every frame. The composite
+// shader finds the tile a pixel is in and adds only the lights listed there, so a pixel
+// costs the lights near it rather than all of them. rlights.h sets uniforms per light and
+// stops at MAX_LIGHTS 4; one light per projectile needs thousands, so it is not used here.
+//
+// Both lists go to the GPU as float textures:
+//   lights: LIGHT_TEXELS_W x (MAX_LIGHTS / LIGHTS_PER_ROW) RGBA32F, two texels per light,
+//           (x, y, radius, 0) then (r, g, b, 0)
+//   tiles:  (columns * TILE_SLOTS) x rows R32F, per tile the count then the light indices
+
+class LightTiles {
+public:
+	static constexpr int TILE = 32;
+	static constexpr int TILE_SLOTS = 64; // the count and up to 63 lights
+	static constexpr int MAX_LIGHTS = 4096;
+	static constexpr int LIGHTS_PER_ROW = 512;
+	static constexpr int LIGHT_TEXELS_W = LIGHTS_PER_ROW * 2;
+	static constexpr int LIGHT_ROWS = MAX_LIGHTS / LIGHTS_PER_ROW;
+	static constexpr int MIN_ROWS_PER_CHUNK = 4;
+
+	// Tiles cover pixelsW x pixelsH framebuffer pixels, 'pixelScale' of them per screen unit
+	void Init(int pixelsW, int pixelsH, float pixelScale = 1.f) {
+		scale = pixelScale;
+		cols = (pixelsW + TILE - 1) / TILE;
+		rows = (pixelsH + TILE - 1) / TILE;
+		slots.assign(static_cast<size_t>(cols) * rows * TILE_SLOTS, 0.f);
+		counts.assign(static_cast<size_t>(cols) * rows, 0);
+		dropped.assign(rows, 0);
+		texels.assign(static_cast<size_t>(MAX_LIGHTS) * 8, 0.f);
+		Clear();
+	}
+
+	void Clear() {
+		x.clear();
+		y.clear();
+		radius.clear();
+	}
+
+	// Screen-space position, binned in framebuffer pixels; anything past MAX_LIGHTS is ignored
+	void Add(Vector2 p, float r, Color c) {
+		if (x.size() >= MAX_LIGHTS) return;
+		p = Vector2{ p.x * scale, p.y * scale };
+		r *= scale;
+		float* t = &texels[x.size() * 8];
+		t[0] = p.x;
+		t[1] = p.y;
+		t[2] = r;
+		t[4] = c.r / 255.f;
+		t[5] = c.g / 255.f;
+		t[6] = c.b / 255.f;
+		x.push_back(p.x);
+		y.push_back(p.y);
+		radius.push_back(r);
+	}
+
+	size_t Count() const { return x.size(); }
+	int Columns() const { return cols; }
+	int Rows() const { return rows; }
+
+	// Rebuilds the tile lists from the lights added since Clear()
+	void Bin() {
+		TileBounds();
+		JobPool::Instance().ParallelFor(rows, MIN_ROWS_PER_CHUNK, [this](int begin, int end, int) {
+			for (int ty = begin; ty < end; ++ty) BinRow(ty);
+		});
+	}
+
+	// Lights that did not fit in a full tile during the last Bin(), counted once per tile
+	size_t Dropped() const {
+		size_t n = 0;
+		for (uint32_t d : dropped) n += d;
+		return n;
+	}
+
+	// Number of lights in tile (tx, ty) and the i-th of them
+	int TileCount(int tx, int ty) const { return static_cast<int>(Tile(tx, ty)[0]); }
+	uint32_t TileLight(int tx, int ty, int i) const { return static_cast<uint32_t>(Tile(tx, ty)[1 + i]); }
+
+	const float* TileData() const { return slots.data(); }
+	const float* LightData() const { return texels.data(); }
+	int LightRowsUsed() const { return static_cast<int>((x.size() + LIGHTS_PER_ROW - 1) / LIGHTS_PER_ROW); }
+
+private:
+	static constexpr size_t LANES = 8;
+
+	const float* Tile(int tx, int ty) const {
+		return &slots[(static_cast<size_t>(ty) * cols + tx) * TILE_SLOTS];
+	}
+
+	// Tile range each light's bounding box covers. Columns are clamped to the screen;
+	// lights entirely left or right of it get an empty row range so no row picks them up.
+	void TileBounds() {
+		size_t n = x.size();
+		size_t padded = (n + LANES - 1) / LANES * LANES;
+		tx0.resize(padded);
+		tx1.resize(padded);
+		ty0.resize(padded);
+		ty1.resize(padded);
+		size_t i = 0;
+#if defined(__AVX2__)
+		const __m256 inv = _mm256_set1_ps(1.f / TILE);
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i last = _mm256_set1_epi32(cols - 1);
+		const __m256i never = _mm256_set1_epi32(INT_MAX);
+		for (; i + LANES <= n; i += LANES) {
+			__m256 px = _mm256_loadu_ps(&x[i]);
+			__m256 py = _mm256_loadu_ps(&y[i]);
+			__m256 r = _mm256_loadu_ps(&radius[i]);
+			__m256i x0 = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_sub_ps(px, r), inv)));
+			__m256i x1 = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_add_ps(px, r), inv)));
+			__m256i y0 = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_sub_ps(py, r), inv)));
+			__m256i y1 = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_mul_ps(_mm256_add_ps(py, r), inv)));
+			__m256i off = _mm256_or_si256(_mm256_cmpgt_epi32(zero, x1), _mm256_cmpgt_epi32(x0, last));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(&tx0[i]), _mm256_max_epi32(x0, zero));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(&tx1[i]), _mm256_min_epi32(x1, last));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(&ty0[i]), _mm256_blendv_epi8(y0, never, off));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(&ty1[i]), y1);
+		}
+#endif
+		for (; i < n; ++i) {
+			int x0 = static_cast<int>(floorf((x[i] - radius[i]) / TILE));
+			int x1 = static_cast<int>(floorf((x[i] + radius[i]) / TILE));
+			tx0[i] = std::max(x0, 0);
+			tx1[i] = std::min(x1, cols - 1);
+			ty0[i] = (x1 < 0 || x0 > cols - 1) ? INT_MAX : static_cast<int>(floorf((y[i] - radius[i]) / TILE));
+			ty1[i] = static_cast<int>(floorf((y[i] + radius[i]) / TILE));
+		}
+		// Padding lanes never match a row
+		for (; i < padded; ++i) {
+			ty0[i] = INT_MAX;
+			ty1[i] = INT_MIN;
+		}
+	}
+
+	// Every light whose row range contains ty, in index order
+	template<typename Fn>
+	void ForEachInRow(int ty, Fn&& fn) const {
+		size_t n = ty0.size();
+		size_t i = 0;
+#if defined(__AVX2__)
+		const __m256i row = _mm256_set1_epi32(ty);
+		for (; i < n; i += LANES) {
+			__m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&ty0[i]));
+			__m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&ty1[i]));
+			__m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(lo, row), _mm256_cmpgt_epi32(row, hi));
+			unsigned hits = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(outside))) & 0xFFu;
+			while (hits) {
+				fn(static_cast<uint32_t>(i + std::countr_zero(hits)));
+				hits &= hits - 1;
+			}
+		}
+#endif
+		for (; i < n; ++i) {
+			if (ty0[i] <= ty && ty <= ty1[i]) fn(static_cast<uint32_t>(i));
+		}
+	}
+
+	// Rows are independent, so each one is written by exactly one worker
+	void BinRow(int ty) {
+		float* row = &slots[static_cast<size_t>(ty) * cols * TILE_SLOTS];
+		uint8_t* count = &counts[static_cast<size_t>(ty) * cols];
+		std::fill(count, count + cols, uint8_t{ 0 });
+		uint32_t lost = 0;
+		float top = static_cast<float>(ty * TILE);
+		ForEachInRow(ty, [&](uint32_t i) {
+			float dy = std::max({ top - y[i], y[i] - (top + TILE), 0.f });
+			float r2 = radius[i] * radius[i] - dy * dy;
+			for (int tx = tx0[i]; tx <= tx1[i]; ++tx) {
+				// Bounding boxes overlap, skip the tiles the circle misses at the corners
+				float left = static_cast<float>(tx * TILE);
+				float dx = std::max({ left - x[i], x[i] - (left + TILE), 0.f });
+				if (dx * dx >= r2) continue;
+				if (count[tx] == TILE_SLOTS - 1) {
+					lost++;
+					continue;
+				}
+				row[tx * TILE_SLOTS + 1 + count[tx]++] = static_cast<float>(i);
+			}
+		});
+		for (int tx = 0; tx < cols; ++tx) row[tx * TILE_SLOTS] = count[tx];
+		dropped[ty] = lost;
+	}
+
+	int cols = 0;
+	int rows = 0;
+	float scale = 1.f;
+	std::vector<float> x, y, radius;
+	std::vector<int32_t> tx0, tx1, ty0, ty1;
+	std::vector<float> slots;
+	std::vector<uint8_t> counts; // slots' counts while binning
+	std::vector<float> texels;
+	std::vector<uint32_t> dropped; // per row
+};
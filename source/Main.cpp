@@ -1,5 +1,8 @@
 ﻿#include <vector>
 #include <algorithm>
+#include <array>
+#include <type_traits>
+#include <utility>
 #include <functional> 
 #include <memory>
 #include <cstdlib>
@@ -9,10 +12,98 @@
 #include <raylib.h>
 #include <raymath.h>
 
+#include "FramePacing.h"
+#include "AsteroidSdf.h"
+#include "CompositePass.h"
+#include "GameEvents.h"
+#include "Jobs.h"
+#include "TimingWheel.h"
+#include "Metrics.h"
+#include "Scripts.h"
+#include "Input.h"
+#include "HitchDetector.h"
+#include "ScreenRecorder.h"
+#include "Sectors.h"
+#include "Swarm.h"
+#include "RenderQueue.h"
+#include "LightTiles.h"
+
 // --- UTILS ---
 namespace Utils {
+	// xorshift64*. The whole state is one integer, so a hitch capture can store it per frame.
+	class GameRandom {
+	public:
+		void Seed(uint64_t seed) {
+			// splitmix64 step, spreads small seeds and never gives the all-zero state
+			uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			state = (z ^ (z >> 31)) | 1;
+		}
+
+		uint64_t State() const { return state; }
+		void SetState(uint64_t s) { state = s ? s : 1; }
+
+		uint64_t Next() {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+
+		// [0, 1)
+		float Float01() {
+			return static_cast<float>(Next() >> 40) * (1.f / 16777216.f);
+		}
+
+		// [min, max], both inclusive like GetRandomValue()
+		int Int(int min, int max) {
+			uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+			return min + static_cast<int>(Next() % range);
+		}
+
+	private:
+		uint64_t state = 1;
+	};
+
+	// Gameplay randomness only; rendering may use anything else
+	inline static GameRandom& Rng() {
+		static GameRandom rng;
+		return rng;
+	}
+
 	inline static float RandomFloat(float min, float max) {
-		return min + static_cast<float>(rand()) / RAND_MAX * (max - min);
+		return min + Rng().Float01() * (max - min);
+	}
+
+	inline static int RandomInt(int min, int max) {
+		return Rng().Int(min, max);
+	}
+
+	// Whether a circle reaches into 'rect' at all, for culling
+	inline static bool Overlaps(Vector2 p, float r, Rectangle rect) {
+		return p.x + r >= rect.x && p.x - r <= rect.x + rect.width && p.y + r >= rect.y && p.y - r <= rect.y + rect.height;
+	}
+
+	// Seconds until a point moving at constant velocity leaves [lo, hi], 0 if already outside
+	inline static float ExitTime(Vector2 p, Vector2 v, Vector2 lo, Vector2 hi) {
+		if (p.x < lo.x || p.x > hi.x || p.y < lo.y || p.y > hi.y) return 0.f;
+		float t = INFINITY;
+		if (v.x > 0) t = fminf(t, (hi.x - p.x) / v.x);
+		else if (v.x < 0) t = fminf(t, (lo.x - p.x) / v.x);
+		if (v.y > 0) t = fminf(t, (hi.y - p.y) / v.y);
+		else if (v.y < 0) t = fminf(t, (lo.y - p.y) / v.y);
+		return t;
+	}
+
+	// Lower bound on the seconds until two circles 'offset' apart, moving at relative
+	// velocity 'vel', come within 'radius'. The roots of |offset + vel*t| = radius multiply
+	// to c/a and add up to -2b/a, so the first one is at least c/(-2b). No sqrt, no branch.
+	inline static float ContactTimeBound(Vector2 offset, Vector2 vel, float radius) {
+		float c = Vector2DotProduct(offset, offset) - radius * radius;
+		float closing = -2.f * Vector2DotProduct(offset, vel);
+		if (c <= 0.f) return 0.f; // already touching
+		return closing > 0.f ? c / closing : INFINITY; // not closing in: never
 	}
 }
 
@@ -39,24 +130,174 @@ public:
 		return inst;
 	}
 
-	void Init(int w, int h, const char* title) {
+	void Init(int w, int h, const char* title, PacingMode pacing = PacingMode::JUST_IN_TIME) {
 		InitWindow(w, h, title);
-		SetTargetFPS(60);
+		DrawCallCounter::Install();
+		pacer.Init(pacing, 60);
 		screenW = w;
 		screenH = h;
+		// Lights are binned in framebuffer pixels, which outnumber screen units on HiDPI displays
+		lights.Init(GetRenderWidth(), GetRenderHeight(), GetRenderWidth() / static_cast<float>(w));
+		if (!sdf.Load()) {
+			TraceLog(LOG_WARNING, "SDF outline shader unavailable, using CPU outlines");
+		}
+		if (!composite.Load(w, h)) {
+			TraceLog(LOG_WARNING, "Composite shader unavailable, using full-screen fills");
+		}
 	}
 
-	void Begin() {
+	void Shutdown() {
+		recorder.Shutdown();
+		composite.Unload();
+		sdf.Unload();
+		CloseWindow();
+	}
+
+	// Screen size only, no window. Used by the benchmarks and other headless runs.
+	void InitHeadless(int w, int h) {
+		screenW = w;
+		screenH = h;
+		lights.Init(w, h);
+	}
+
+	// No window or GL: frames are rasterized on the CPU into Software(), see SoftRaster.h.
+	// Textures to draw come from Software().AddTexture().
+	void InitSoftware(int w, int h) {
+		InitHeadless(w, h);
+		soft.Init(w, h);
+		queue.SetSoftware(&soft);
+	}
+
+	// Late input poll, call right before simulating the frame
+	float BeginFrame() {
+		return pacer.BeginFrame();
+	}
+
+	// Starts the scene; background, flash and dim are applied in Composite()
+	void Begin(const FrameOverlay& ov) {
+		overlay = ov;
+		frameDrawCalls = DrawCallCounter::Total();
+		queue.SetLayer(RenderLayer::BACKGROUND);
+		if (queue.Software()) {
+			soft.Clear(CompositePass::BackgroundColor(ov.time, ov.nightmare));
+			return;
+		}
 		BeginDrawing();
-		ClearBackground(BLACK);
+		if (composite.IsReady()) {
+			composite.BeginScene();
+		}
+		else {
+			ClearBackground(CompositePass::BackgroundColor(ov.time, ov.nightmare));
+		}
+	}
+
+	// Anything drawn after this goes on top of the finished frame
+	void Composite() {
+		queue.Flush();
+		if (queue.Software()) {
+			// The composite shader's flash and dim without it; no lights
+			Rectangle screen = { 0, 0, static_cast<float>(screenW), static_cast<float>(screenH) };
+			if (overlay.flash > 0.f) soft.Rect(screen, Fade(WHITE, overlay.flash));
+			if (overlay.dim > 0.f) soft.Rect(screen, Fade(BLACK, overlay.dim));
+			return;
+		}
+		composite.Composite(overlay, lights);
+	}
+
+	// Scene draws in world space, until EndWorld()
+	void BeginWorld(const Camera2D& camera) {
+		if (queue.Software()) soft.SetCamera(camera);
+		else BeginMode2D(camera);
+	}
+
+	// Flushes the queue, it draws with the camera set when it flushes
+	void EndWorld() {
+		queue.Flush();
+		if (queue.Software()) soft.ResetCamera();
+		else EndMode2D();
 	}
 
 	void End() {
+		queue.Flush();
+		if (queue.Software()) {
+			soft.Flush();
+			RenderQueue::Stats q = queue.TakeStats();
+			lastFrame = { 0, q.commands, q.stateChanges };
+			return;
+		}
 		EndDrawing();
+		RenderQueue::Stats q = queue.TakeStats();
+		lastFrame = { DrawCallCounter::Total() - frameDrawCalls, q.commands, q.stateChanges };
+		recorder.EndFrame();
+		if (recorder.IsRecording()) {
+			// Drawn after the readback so it stays out of the clip
+			DrawCircle(30, screenH - 20, 10, MAROON);
+			DrawText("REC", 50, screenH - 30, 20, RED);
+			rlDrawRenderBatchActive();
+		}
+		pacer.EndFrame();
+	}
+
+	FramePacer& Pacer() {
+		return pacer;
+	}
+
+	AsteroidSdfRenderer& Sdf() {
+		return sdf;
+	}
+
+	ScreenRecorder& Recorder() {
+		return recorder;
+	}
+
+	// Scene draws go through here and are sorted into batches, see RenderQueue.h
+	RenderQueue& Queue() {
+		return queue;
+	}
+
+	// Screen-space lights for this frame, fill and Bin() before Composite()
+	LightTiles& Lights() {
+		return lights;
+	}
+
+	// The CPU framebuffer after InitSoftware()
+	SoftRaster& Software() {
+		return soft;
+	}
+
+	// LoadTexture() for the game's sprites. After InitSoftware() the image goes to Software()
+	// instead, so the same draw code runs there. A missing file gives id 0 either way.
+	Texture2D LoadSprite(const char* path, int filter, bool mipmaps) {
+		if (queue.Software()) {
+			if (!FileExists(path)) return {};
+			Image image = LoadImage(path);
+			Texture2D t = soft.AddTexture(image);
+			UnloadImage(image);
+			return t;
+		}
+		Texture2D t = LoadTexture(path);
+		if (mipmaps) GenTextureMipmaps(&t);
+		SetTextureFilter(t, filter);
+		return t;
+	}
+
+	void UnloadSprite(Texture2D t) {
+		if (!queue.Software() && t.id != 0) UnloadTexture(t);
+	}
+
+	// GL draw calls of the whole frame, with what the queue flushed in it
+	struct FrameStats {
+		uint64_t drawCalls = 0;
+		size_t commands = 0;
+		size_t stateChanges = 0;
+	};
+
+	const FrameStats& LastFrame() const {
+		return lastFrame;
 	}
 
 	void DrawPoly(const Vector2& pos, int sides, float radius, float rot) {
-		DrawPolyLines(pos, sides, radius, rot, BLACK);
+		queue.PolyLines(pos, sides, radius, rot, BLACK);
 	}
 
 	int Width() const {
@@ -72,6 +313,16 @@ private:
 
 	int screenW{};
 	int screenH{};
+	FramePacer pacer;
+	AsteroidSdfRenderer sdf;
+	CompositePass composite;
+	ScreenRecorder recorder;
+	FrameOverlay overlay;
+	RenderQueue queue;
+	LightTiles lights;
+	SoftRaster soft;
+	uint64_t frameDrawCalls = 0;
+	FrameStats lastFrame;
 };
 
 // --- ASTEROID HIERARCHY ---
@@ -83,24 +334,65 @@ public:
 	}
 	virtual ~Asteroid() = default;
 
-	bool Update(float dt) {
+	// Straight line at constant speed; leaving the awake sectors is scheduled from ExitTime()
+	void Update(float dt) {
 		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
 		transform.rotation += physics.rotationSpeed * dt;
-		if (transform.position.x < -GetRadius() || transform.position.x > Renderer::Instance().Width() + GetRadius() ||
-			transform.position.y < -GetRadius() || transform.position.y > Renderer::Instance().Height() + GetRadius())
-			return false;
-		return true;
 	}
+
+	// Update() for a sleeper: any number of seconds at once, wrapping around the world edges
+	void Drift(float seconds, Vector2 world) {
+		Vector2 p = Vector2Add(transform.position, Vector2Scale(physics.velocity, seconds));
+		p.x -= floorf(p.x / world.x) * world.x;
+		p.y -= floorf(p.y / world.y) * world.y;
+		transform.position = p;
+		transform.rotation = fmodf(transform.rotation + physics.rotationSpeed * seconds, 360.f);
+	}
+
+	// Seconds until the centre leaves 'box'
+	float ExitTime(Rectangle box) const {
+		return Utils::ExitTime(transform.position, physics.velocity, { box.x, box.y }, { box.x + box.width, box.y + box.height });
+	}
+
+	void MoveBy(Vector2 offset) {
+		transform.position = Vector2Add(transform.position, offset);
+	}
+
 	virtual void Draw() const = 0;
 
+	// Queues the asteroid as an SDF instance; shapes without an SDF return false and use Draw()
+	virtual bool DrawSdf(AsteroidSdfRenderer& sdf) const {
+		return false;
+	}
+
 	Vector2 GetPosition() const {
 		return transform.position;
 	}
 
+	Vector2 GetVelocity() const {
+		return physics.velocity;
+	}
+
 	float constexpr GetRadius() const {
 		return 16.f * (float)render.size;
 	}
 
+	uint32_t GetHandle() const {
+		return handle;
+	}
+
+	void SetHandle(uint32_t h) {
+		handle = h;
+	}
+
+	uint32_t GetExitTick() const {
+		return exitTick;
+	}
+
+	void SetExitTick(uint32_t t) {
+		exitTick = t;
+	}
+
 	int GetDamage() const {
 		return baseDamage * static_cast<int>(render.size);
 	}
@@ -112,10 +404,10 @@ public:
 protected:
 	void init(int screenW, int screenH, bool nightmare = false) {
 		// Choose size
-		render.size = static_cast<Renderable::Size>(1 << GetRandomValue(0, 2));
+		render.size = static_cast<Renderable::Size>(1 << Utils::RandomInt(0, 2));
 
 		// Spawn at random edge
-		switch (GetRandomValue(0, 3)) {
+		switch (Utils::RandomInt(0, 3)) {
 		case 0:
 			transform.position = { Utils::RandomFloat(0, screenW), -GetRadius() };
 			break;
@@ -153,8 +445,12 @@ protected:
 	TransformA transform;
 	Physics    physics;
 	Renderable render;
+	uint32_t   handle = HandleMap::INVALID;
+	uint32_t   exitTick = 0; // the exit that is still valid, 0 if none
 
 	int baseDamage = 0;
+
+public:
 	static constexpr float LIFE = 10.f;
 	static constexpr float SPEED_MIN = 125.f;
 	static constexpr float SPEED_MAX = 250.f;
@@ -183,32 +479,30 @@ public:
 		Renderer::Instance().DrawPoly(transform.position, 5, GetRadius(), transform.rotation);
 	}
 };
-void DrawHeart(Vector2 center, float size, float rotation) {
-	const int segments = 100;
-	Vector2 points[segments];
-	for (int i = 0; i < segments; ++i) {
-		float t = i * 2 * PI / segments;
+// Outline point math, kept separate from drawing so it can be benchmarked
+static constexpr int HEART_SEGMENTS = 100;
+static constexpr int STAR_POINTS = 10; // 5 ramion * 2 (zewnętrzne i wewnętrzne)
+static constexpr int FLOWER_SEGMENTS = 100;
+
+void BuildHeartOutline(Vector2* points, Vector2 center, float size, float rotation) {
+	float angle = rotation * DEG2RAD;
+	float ca = cosf(angle);
+	float sa = sinf(angle);
+	for (int i = 0; i < HEART_SEGMENTS; ++i) {
+		float t = i * 2 * PI / HEART_SEGMENTS;
 		float x = 16 * powf(sinf(t), 3);
 		float y = 13 * cosf(t) - 5 * cosf(2 * t) - 2 * cosf(3 * t) - cosf(4 * t);
 		x *= size / 32.0f;
 		y *= size / 32.0f;
-		float angle = rotation * DEG2RAD;
-		float rx = x * cosf(angle) - y * sinf(angle);
-		float ry = x * sinf(angle) + y * cosf(angle);
+		float rx = x * ca - y * sa;
+		float ry = x * sa + y * ca;
 		points[i] = { center.x + rx, center.y - ry };
 	}
-
-	for (int i = 0; i < segments - 1; ++i) {
-		DrawLineV(points[i], points[i + 1], RED);
-	}
-	DrawLineV(points[segments - 1], points[0], RED);
 }
 
-void DrawStar(Vector2 center, float radius, float rotation) {
-	const int points = 10; // 5 ramion * 2 (zewnętrzne i wewnętrzne)
-	Vector2 star[points];
-	float angleStep = 2 * PI / points;
-	for (int i = 0; i < points; ++i) {
+void BuildStarOutline(Vector2* star, Vector2 center, float radius, float rotation) {
+	float angleStep = 2 * PI / STAR_POINTS;
+	for (int i = 0; i < STAR_POINTS; ++i) {
 		float r = (i % 2 == 0) ? radius : radius * 0.5f;
 		float angle = i * angleStep + rotation * DEG2RAD;
 		star[i] = {
@@ -216,27 +510,43 @@ void DrawStar(Vector2 center, float radius, float rotation) {
 			center.y + r * sinf(angle)
 		};
 	}
-	for (int i = 0; i < points; ++i) {
-		DrawLineV(star[i], star[(i + 1) % points], YELLOW);
-	}
 }
-void DrawFlower(Vector2 center, float radius, float rotation) {
-	const int segments = 100;
-	Vector2 points[segments];
-	for (int i = 0; i < segments; ++i) {
-		float t = i * 2 * PI / segments;
+
+void BuildFlowerOutline(Vector2* points, Vector2 center, float radius, float rotation) {
+	float angle = rotation * DEG2RAD;
+	float ca = cosf(angle);
+	float sa = sinf(angle);
+	for (int i = 0; i < FLOWER_SEGMENTS; ++i) {
+		float t = i * 2 * PI / FLOWER_SEGMENTS;
 		float r = radius * (1 + 0.3f * sinf(6 * t));
 		float x = r * cosf(t);
 		float y = r * sinf(t);
-		float angle = rotation * DEG2RAD;
-		float rx = x * cosf(angle) - y * sinf(angle);
-		float ry = x * sinf(angle) + y * cosf(angle);
+		float rx = x * ca - y * sa;
+		float ry = x * sa + y * ca;
 		points[i] = { center.x + rx, center.y + ry };
 	}
-	for (int i = 0; i < segments - 1; ++i) {
-		DrawLineV(points[i], points[i + 1], MAGENTA);
-	}
-	DrawLineV(points[segments - 1], points[0], MAGENTA);
+}
+
+void DrawClosedOutline(const Vector2* points, int count, Color color) {
+	Renderer::Instance().Queue().Outline(points, count, color);
+}
+
+void DrawHeart(Vector2 center, float size, float rotation) {
+	Vector2 points[HEART_SEGMENTS];
+	BuildHeartOutline(points, center, size, rotation);
+	DrawClosedOutline(points, HEART_SEGMENTS, RED);
+}
+
+void DrawStar(Vector2 center, float radius, float rotation) {
+	Vector2 star[STAR_POINTS];
+	BuildStarOutline(star, center, radius, rotation);
+	DrawClosedOutline(star, STAR_POINTS, YELLOW);
+}
+
+void DrawFlower(Vector2 center, float radius, float rotation) {
+	Vector2 points[FLOWER_SEGMENTS];
+	BuildFlowerOutline(points, center, radius, rotation);
+	DrawClosedOutline(points, FLOWER_SEGMENTS, MAGENTA);
 }
 
 
@@ -246,6 +556,10 @@ public:
 	void Draw() const override {
 		DrawHeart(transform.position, GetRadius(), transform.rotation);
 	}
+	bool DrawSdf(AsteroidSdfRenderer& sdf) const override {
+		sdf.Submit(transform.position, GetRadius(), transform.rotation, AsteroidSdfRenderer::HEART, RED);
+		return true;
+	}
 };
 
 class StarShapeAsteroid : public Asteroid {
@@ -254,6 +568,10 @@ public:
 	void Draw() const override {
 		DrawStar(transform.position, GetRadius(), transform.rotation); // 10-bok gwiazdka
 	}
+	bool DrawSdf(AsteroidSdfRenderer& sdf) const override {
+		sdf.Submit(transform.position, GetRadius(), transform.rotation, AsteroidSdfRenderer::STAR, YELLOW);
+		return true;
+	}
 };
 
 class FlowerAsteroid : public Asteroid {
@@ -262,6 +580,10 @@ public:
 	void Draw() const override {
 		DrawFlower(transform.position, GetRadius(), transform.rotation); // 8-bok = kwiatek
 	}
+	bool DrawSdf(AsteroidSdfRenderer& sdf) const override {
+		sdf.Submit(transform.position, GetRadius(), transform.rotation, AsteroidSdfRenderer::FLOWER, MAGENTA);
+		return true;
+	}
 };
 // Shape selector
 enum class AsteroidShape { TRIANGLE = 3, SQUARE = 4, PENTAGON = 5, RANDOM = 0 };
@@ -269,7 +591,7 @@ enum class AsteroidShape { TRIANGLE = 3, SQUARE = 4, PENTAGON = 5, RANDOM = 0 };
 // Factory
 static inline std::unique_ptr<Asteroid> MakeAsteroid(int w, int h, AsteroidShape shape, bool nightmare = false) {
 	if (!nightmare) {
-		int r = GetRandomValue(0, 2);
+		int r = Utils::RandomInt(0, 2);
 		switch (r) {
 		case 0: return std::make_unique<HeartShapeAsteroid>(w, h);
 		case 1: return std::make_unique<StarShapeAsteroid>(w, h);
@@ -283,118 +605,247 @@ static inline std::unique_ptr<Asteroid> MakeAsteroid(int w, int h, AsteroidShape
 	case AsteroidShape::SQUARE: return std::make_unique<SquareAsteroid>(w, h);
 	case AsteroidShape::PENTAGON: return std::make_unique<PentagonAsteroid>(w, h);
 	default:
-		return MakeAsteroid(w, h, static_cast<AsteroidShape>(3 + GetRandomValue(0, 2)), nightmare);
+		return MakeAsteroid(w, h, static_cast<AsteroidShape>(3 + Utils::RandomInt(0, 2)), nightmare);
 	}
 }
 
 
-// --- PROJECTILE HIERARCHY ---
+// --- WEAPONS ---
+// Everything a weapon is, as compile-time data. Shots of each weapon live in their own
+// compact array and every kernel that touches them is a template instantiated per
+// weapon, so per-weapon differences are resolved at compile time, not per shot.
 enum class WeaponType { LASER, BULLET, COUNT };
-class Projectile {
-public:
-	Projectile(Vector2 pos, Vector2 vel, int dmg, WeaponType wt, bool nm = false)
-		: nightmare(nm)
-	{
-		transform.position = pos;
-		physics.velocity = vel;
-		baseDamage = dmg;
-		type = wt;
-	}
+static constexpr int WEAPON_COUNT = static_cast<int>(WeaponType::COUNT);
+
+enum class ShotLook { BEAM, SPRITE };
+
+struct WeaponDef {
+	const char* name;
+	const char* nightmareName;
+	float fireRate; // shots/sec
+	float spacing;  // px between shots
+	float radius;   // for collisions
+	int damage;
+	ShotLook look;
+	float beamLength;
+	float beamWidth;
+	const char* sprite;
+	const char* nightmareSprite;
+	float spriteScale;
+	float lightRadius; // every shot is a point light, see LightTiles.h
+	Color light;
+	Color nightmareLight;
+
+	constexpr float Speed() const { return spacing * fireRate; }
+	// Half extent for culling against the view
+	constexpr float Extent() const { return look == ShotLook::BEAM ? beamLength : radius; }
+};
 
-	static void LoadAssets() {
-		if (!starLoaded) {
-			starTexture = LoadTexture("gwiazda.png");
-			starTextureNightmare = LoadTexture("blyskawica.png");
-			GenTextureMipmaps(&starTexture);
-			GenTextureMipmaps(&starTextureNightmare);
-			SetTextureFilter(starTexture, TEXTURE_FILTER_BILINEAR);
-			SetTextureFilter(starTextureNightmare, TEXTURE_FILTER_BILINEAR);
-			starLoaded = true;
-		}
-	}
+inline constexpr WeaponDef WEAPONS[WEAPON_COUNT] = {
+	// LASER: tęczowy promień
+	{ "LOVE", "DEATH", 18.f, 40.f, 2.f, 20, ShotLook::BEAM, 30.f, 4.f, nullptr, nullptr, 0.f,
+		90.f, { 255, 140, 220, 255 }, { 255, 40, 30, 255 } },
+	// BULLET: gwiazdka, radius = half the 801 px sprite at its scale
+	{ "FRIENDSHIP", "TREMOR", 22.f, 20.f, 801 * 0.06f * 0.5f, 10, ShotLook::SPRITE, 0.f, 0.f, "gwiazda.png", "blyskawica.png", 0.06f,
+		70.f, { 255, 220, 110, 255 }, { 140, 190, 255, 255 } },
+};
 
-	static void UnloadAssets() {
-		if (starLoaded) {
-			UnloadTexture(starTexture);
-			UnloadTexture(starTextureNightmare);
-			starLoaded = false;
+constexpr const WeaponDef& Weapon(WeaponType w) {
+	return WEAPONS[static_cast<int>(w)];
+}
+
+// Calls fn(std::integral_constant<WeaponType, W>{}) for every weapon, unrolled at compile time
+template<typename Fn>
+void ForEachWeapon(Fn&& fn) {
+	[&]<int... I>(std::integer_sequence<int, I...>) {
+		(fn(std::integral_constant<WeaponType, static_cast<WeaponType>(I)>{}), ...);
+	}(std::make_integer_sequence<int, WEAPON_COUNT>{});
+}
+
+// One shot in flight. The weapon is the array it is in.
+struct Shot {
+	Vector2 position;
+	Vector2 velocity;
+	uint32_t nextCheckTick; // first sim tick it may touch an asteroid, see PredictCheckTick()
+};
+
+static_assert(sizeof(Shot) == 20, "Shot is meant to stay position + velocity + one tick");
+
+using ShotArrays = std::array<std::vector<Shot>, WEAPON_COUNT>;
+
+// Events name a shot by weapon and index in that weapon's array
+static constexpr uint32_t SHOT_INDEX_BITS = 24;
+static constexpr uint32_t SHOT_INDEX_MASK = (1u << SHOT_INDEX_BITS) - 1;
+
+constexpr uint32_t ShotId(WeaponType w, int index) {
+	return static_cast<uint32_t>(w) << SHOT_INDEX_BITS | static_cast<uint32_t>(index);
+}
+
+inline size_t ShotCount(const ShotArrays& shots) {
+	size_t n = 0;
+	for (const auto& s : shots) n += s.size();
+	return n;
+}
+
+// Sprite textures of the SPRITE weapons, by weapon and nightmare mode
+class ShotSprites {
+public:
+	static void Load() {
+		for (int w = 0; w < WEAPON_COUNT; ++w) {
+			if (WEAPONS[w].look != ShotLook::SPRITE) continue;
+			const char* files[2] = { WEAPONS[w].sprite, WEAPONS[w].nightmareSprite };
+			for (int nm = 0; nm < 2; ++nm) {
+				textures[w][nm] = Renderer::Instance().LoadSprite(files[nm], TEXTURE_FILTER_BILINEAR, true);
+			}
 		}
 	}
 
-	bool Update(float dt) {
-		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
-		return transform.position.x < 0 || transform.position.x > Renderer::Instance().Width() ||
-			transform.position.y < 0 || transform.position.y > Renderer::Instance().Height();
-	}
-
-	void Draw() const {
-		if (type == WeaponType::BULLET) {
-			if (starLoaded) {
-				Texture2D tex = nightmare ? starTextureNightmare : starTexture;
-				Vector2 drawPos = {
-					transform.position.x - (tex.width * BULLET_SCALE) / 2.0f,
-					transform.position.y - (tex.height * BULLET_SCALE) / 2.0f
-				};
-				DrawTextureEx(tex, drawPos, 0.0f, BULLET_SCALE, WHITE);
+	static void Unload() {
+		for (auto& pair : textures) {
+			for (Texture2D& tex : pair) {
+				Renderer::Instance().UnloadSprite(tex);
+				tex = {};
 			}
 		}
+	}
 
-		else {
-	
-			static constexpr float LASER_LENGTH = 30.f;
-			Rectangle lr = { transform.position.x - 2.f, transform.position.y - LASER_LENGTH, 4.f, LASER_LENGTH };
-			float t = GetTime() * 2.0f;
-			Color rainbow = nightmare ? RED : Color{
-				(unsigned char)((sinf(t + 0.f) * 0.5f + 0.5f) * 255),
-				(unsigned char)((sinf(t + 2.f) * 0.5f + 0.5f) * 255),
-				(unsigned char)((sinf(t + 4.f) * 0.5f + 0.5f) * 255),
-				255
-			};
-			float len = nightmare ? LASER_LENGTH * 1.5f : LASER_LENGTH;
-
-			DrawRectangleRec(lr, rainbow);
-		}
+	static Texture2D Get(WeaponType w, bool nightmare) {
+		return textures[static_cast<int>(w)][nightmare ? 1 : 0];
 	}
 
-	Vector2 GetPosition() const { return transform.position; }
+private:
+	inline static Texture2D textures[WEAPON_COUNT][2]{};
+};
 
-	float GetRadius() const {
-		if (type == WeaponType::BULLET) {
-			return (starTexture.width * BULLET_SCALE) / 2.f;
+// 'time' in seconds cycles the beam colours
+template<WeaponType W>
+void DrawShots(const std::vector<Shot>& shots, Rectangle view, bool nightmare, float time) {
+	constexpr WeaponDef def = Weapon(W);
+	RenderQueue& queue = Renderer::Instance().Queue();
+	if constexpr (def.look == ShotLook::BEAM) {
+		float t = time * 2.0f;
+		Color rainbow = nightmare ? RED : Color{
+			(unsigned char)((sinf(t + 0.f) * 0.5f + 0.5f) * 255),
+			(unsigned char)((sinf(t + 2.f) * 0.5f + 0.5f) * 255),
+			(unsigned char)((sinf(t + 4.f) * 0.5f + 0.5f) * 255),
+			255
+		};
+		for (const Shot& s : shots) {
+			if (!Utils::Overlaps(s.position, def.Extent(), view)) continue;
+			queue.Rect({ s.position.x - def.beamWidth * 0.5f, s.position.y - def.beamLength, def.beamWidth, def.beamLength }, rainbow);
 		}
-		else {
-			return 2.f;
+	}
+	else {
+		Texture2D tex = ShotSprites::Get(W, nightmare);
+		if (tex.id == 0) return;
+		Vector2 half = { tex.width * def.spriteScale * 0.5f, tex.height * def.spriteScale * 0.5f };
+		for (const Shot& s : shots) {
+			if (!Utils::Overlaps(s.position, def.Extent(), view)) continue;
+			queue.Texture(tex, Vector2Subtract(s.position, half), 0.0f, def.spriteScale, WHITE);
 		}
 	}
+}
 
-	int GetDamage() const { return baseDamage; }
-
-private:
-	TransformA transform;
-	Physics    physics;
-	int        baseDamage;
-	WeaponType type;
-
-	inline static Texture2D starTexture;
-	inline static bool starLoaded = false;
-	inline static constexpr float BULLET_SCALE = 0.06f;
-	inline static Texture2D starTextureNightmare;
-	inline static bool nightmareAssetsLoaded = false;
-	bool nightmare = false;
+// Sector grid, faintly, so there is something to see moving in empty space
+void DrawSectorGrid(Rectangle view, float size, int columns, int rows) {
+	RenderQueue& queue = Renderer::Instance().Queue();
+	int x0 = std::max(static_cast<int>(view.x / size), 0);
+	int y0 = std::max(static_cast<int>(view.y / size), 0);
+	int x1 = std::min(static_cast<int>((view.x + view.width) / size), columns - 1);
+	int y1 = std::min(static_cast<int>((view.y + view.height) / size), rows - 1);
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			queue.RectLines({ x * size, y * size, size, size }, 2.f, Fade(GRAY, 0.3f));
+		}
+	}
+}
 
+// One light per shot whose light reaches into the view, in screen coordinates
+template<WeaponType W>
+void AddShotLights(const std::vector<Shot>& shots, Rectangle view, bool nightmare, LightTiles& lights) {
+	constexpr WeaponDef def = Weapon(W);
+	constexpr float lift = def.look == ShotLook::BEAM ? def.beamLength * 0.5f : 0.f; // beams light from their middle
+	Color color = nightmare ? def.nightmareLight : def.light;
+	for (const Shot& s : shots) {
+		Vector2 p = { s.position.x - view.x, s.position.y - lift - view.y };
+		if (!Utils::Overlaps(p, def.lightRadius, { 0, 0, view.width, view.height })) continue;
+		lights.Add(p, def.lightRadius, color);
+	}
+}
 
-};
+// --- MOVEMENT & COLLISION PHASES ---
+// Phases never remove anything themselves: they flag leavers and append events, and
+// Application::ResolveEvents applies the results. Each phase works on an index range so
+// it can be split across JobPool workers, each writing into its own EventBuffer.
+// Everything moves in straight lines, so leaving the awake sectors is not checked here:
+// exit times are computed at spawn and expire from Application's timing wheel. Shots are
+// the exception, they are too many and too short-lived; AdvanceShots() flags them.
+
+// Fixed-rate simulation clock used for scheduling, independent of the frame rate
+static constexpr double SIM_TICK_RATE = 60.0;
+// A projectile re-tests all asteroids at least this often, even with no contact predicted
+static constexpr uint32_t PREDICT_TICKS = 30;
+// Extra radius so float error never lets a predicted contact start early
+static constexpr float PREDICT_MARGIN = 1.f;
+
+// Tick to test a pair again when checked at 'now' and contact is at least 'seconds' away.
+// The sim time at tick 'now' may be up to one tick past now / SIM_TICK_RATE, so one tick
+// is taken off on top of rounding down.
+inline uint32_t PredictCheckTick(uint32_t now, float seconds) {
+	float ticks = seconds * static_cast<float>(SIM_TICK_RATE);
+	if (!(ticks < PREDICT_TICKS)) return now + PREDICT_TICKS;
+	return ticks >= 2.f ? now + static_cast<uint32_t>(ticks) - 1 : now;
+}
 
-inline static Projectile MakeProjectile(WeaponType wt,
-	const Vector2 pos,
-	float speed, bool nightmare = false)
+// Moves shots and flags (with an ENTITY_EXPIRED event) the ones that left 'bounds'
+template<WeaponType W>
+void AdvanceShots(std::vector<Shot>& shots, std::vector<uint8_t>& gone, Rectangle bounds, float dt, int begin, int end,
+	EventBuffer& out)
 {
-	Vector2 vel{ 0, -speed };
-	if (wt == WeaponType::LASER) {
-		return Projectile(pos, vel, 20, wt, nightmare);
+	for (int i = begin; i < end; ++i) {
+		Vector2& p = shots[i].position;
+		p = Vector2Add(p, Vector2Scale(shots[i].velocity, dt));
+		if (p.x < bounds.x || p.x > bounds.x + bounds.width || p.y < bounds.y || p.y > bounds.y + bounds.height) {
+			gone[i] = 1;
+			out.Push(GameEventType::ENTITY_EXPIRED, ShotId(W, i), 0, 0, EntityKind::PROJECTILE);
+		}
 	}
-	else {
-		return Projectile(pos, vel, 10, wt, nightmare);
+}
+
+void AdvanceAsteroids(std::vector<std::unique_ptr<Asteroid>>& asteroids, float dt, int begin, int end) {
+	for (int i = begin; i < end; ++i) {
+		asteroids[i]->Update(dt);
+	}
+}
+
+// Reports every overlapping pair; resolving in (shot, asteroid) order keeps the
+// first still-alive asteroid per shot, same as erasing while iterating did.
+// Shots whose next check tick is still ahead of 'tick' are skipped; the others
+// test every asteroid and store when the earliest possible contact is. Only the
+// shots in [begin, end) are written.
+template<WeaponType W>
+void DetectShotHits(std::vector<Shot>& shots, const std::vector<uint8_t>& shotGone,
+	const std::vector<std::unique_ptr<Asteroid>>& asteroids, const std::vector<uint8_t>& asteroidGone,
+	uint32_t tick, int begin, int end, EventBuffer& out)
+{
+	constexpr float pr = Weapon(W).radius;
+	for (int p = begin; p < end; ++p) {
+		if (shotGone[p] || shots[p].nextCheckTick > tick) continue;
+		Vector2 pp = shots[p].position;
+		Vector2 pv = shots[p].velocity;
+		float soonest = INFINITY;
+		for (size_t a = 0; a < asteroids.size(); ++a) {
+			if (asteroidGone[a]) continue;
+			Vector2 offset = Vector2Subtract(asteroids[a]->GetPosition(), pp);
+			float radius = pr + asteroids[a]->GetRadius();
+			if (Vector2LengthSqr(offset) < radius * radius) {
+				out.Push(GameEventType::ASTEROID_DESTROYED, ShotId(W, p), static_cast<uint32_t>(a), asteroids[a]->GetSize() * 10);
+			}
+			// Hits give a negative bound: the asteroid may go to another shot, look again next tick
+			Vector2 vel = Vector2Subtract(asteroids[a]->GetVelocity(), pv);
+			soonest = fminf(soonest, Utils::ContactTimeBound(offset, vel, radius + PREDICT_MARGIN));
+		}
+		shots[p].nextCheckTick = PredictCheckTick(tick, soonest);
 	}
 }
 
@@ -406,17 +857,13 @@ public:
 			screenW * 0.5f,
 			screenH * 0.5f
 		};
-		hp = 100;
+		hp = MAX_HP;
 		speed = 250.f;
 		alive = true;
-
-		// per-weapon fire rate & spacing
-		fireRateLaser = 18.f; // shots/sec
-		fireRateBullet = 22.f;
-		spacingLaser = 40.f; // px between lasers
-		spacingBullet = 20.f;
 	}
 	virtual ~Ship() = default;
+
+	static constexpr int MAX_HP = 100;
 	virtual void Update(float dt) = 0;
 	virtual void Draw() const = 0;
 
@@ -434,18 +881,18 @@ public:
 		return transform.position;
 	}
 
-	virtual float GetRadius() const = 0;
-
-	int GetHP() const {
-		return hp;
+	void ClampTo(Vector2 lo, Vector2 hi) {
+		transform.position = Vector2Clamp(transform.position, lo, hi);
 	}
 
-	float GetFireRate(WeaponType wt) const {
-		return (wt == WeaponType::LASER) ? fireRateLaser : fireRateBullet;
+	void MoveBy(Vector2 offset) {
+		transform.position = Vector2Add(transform.position, offset);
 	}
 
-	float GetSpacing(WeaponType wt) const {
-		return (wt == WeaponType::LASER) ? spacingLaser : spacingBullet;
+	virtual float GetRadius() const = 0;
+
+	int GetHP() const {
+		return hp;
 	}
 
 protected:
@@ -453,34 +900,33 @@ protected:
 	int        hp;
 	float      speed;
 	bool       alive;
-	float      fireRateLaser;
-	float      fireRateBullet;
-	float      spacingLaser;
-	float      spacingBullet;
 };
 
 class PlayerShip :public Ship {
 public:
 	PlayerShip(int w, int h) : Ship(w, h) {
-		texture = LoadTexture("unicorn.png");
-		nightmareTexture = LoadTexture("unicorn_nightmare.png");
-		GenTextureMipmaps(&texture);                                                        // Generate GPU mipmaps for a texture
-		GenTextureMipmaps(&nightmareTexture);
-		SetTextureFilter(texture, 2);
-		SetTextureFilter(nightmareTexture, TEXTURE_FILTER_BILINEAR);
+		texture = Renderer::Instance().LoadSprite("unicorn.png", TEXTURE_FILTER_TRILINEAR, true);
+		nightmareTexture = Renderer::Instance().LoadSprite("unicorn_nightmare.png", TEXTURE_FILTER_BILINEAR, true);
 		scale = 0.08f;
 	}
 	~PlayerShip() {
-		UnloadTexture(texture);
-		UnloadTexture(nightmareTexture);
+		Renderer::Instance().UnloadSprite(texture);
+		Renderer::Instance().UnloadSprite(nightmareTexture);
+	}
+
+	// Movement keys of this frame, applied by the next Update()
+	void Steer(const InputFrame& in) {
+		steer = {};
+		if (in.Down(BTN_UP)) steer.y -= 1.f;
+		if (in.Down(BTN_DOWN)) steer.y += 1.f;
+		if (in.Down(BTN_LEFT)) steer.x -= 1.f;
+		if (in.Down(BTN_RIGHT)) steer.x += 1.f;
 	}
 
 	void Update(float dt) override {
 		if (alive) {
-			if (IsKeyDown(KEY_W)) transform.position.y -= speed * dt;
-			if (IsKeyDown(KEY_S)) transform.position.y += speed * dt;
-			if (IsKeyDown(KEY_A)) transform.position.x -= speed * dt;
-			if (IsKeyDown(KEY_D)) transform.position.x += speed * dt;
+			transform.position.x += steer.x * speed * dt;
+			transform.position.y += steer.y * speed * dt;
 		}
 		else {
 			transform.position.y += speed * dt;
@@ -494,13 +940,13 @@ public:
 	void Draw() const override {
 		if (!alive && fmodf(GetTime(), 0.4f) > 0.2f) return;
 		Texture2D tex = useNightmareTexture ? nightmareTexture : texture;
+		float usedScale = useNightmareTexture ? 0.4f : scale;
+		// Centred on the sprite that is drawn
 		Vector2 dstPos = {
-										 transform.position.x - (texture.width * scale) * 0.5f,
-										 transform.position.y - (texture.height * scale) * 0.5f
+										 transform.position.x - (tex.width * usedScale) * 0.5f,
+										 transform.position.y - (tex.height * usedScale) * 0.5f
 		};
-		if (useNightmareTexture) DrawTextureEx(tex, dstPos, 0.0f, 0.4f, WHITE);
-		else DrawTextureEx(tex, dstPos, 0.0f, scale, WHITE);
-		
+		Renderer::Instance().Queue().Texture(tex, dstPos, 0.0f, usedScale, WHITE);
 	}
 
 	float GetRadius() const override {
@@ -515,6 +961,63 @@ private:
 	float     scale;
 	Texture2D nightmareTexture;
 	bool useNightmareTexture = false;
+	Vector2 steer{};
+};
+
+// Swarm member. Steering is planned every few ticks from its neighbours (FlockSteer) and
+// applied every tick by Update().
+class EnemyShip :public Ship {
+public:
+	EnemyShip(Vector2 position, Vector2 velocity, uint32_t phase, bool nightmare) : Ship(0, 0), velocity(velocity), phase(phase) {
+		transform.position = position;
+		hp = 1;
+		speed = FLOCK.maxSpeed;
+		color = nightmare ? MAROON : SKYBLUE;
+	}
+
+	void Update(float dt) override {
+		velocity = Vector2ClampValue(Vector2Add(velocity, Vector2Scale(accel, dt)), 0.f, speed);
+		transform.position = Vector2Add(transform.position, Vector2Scale(velocity, dt));
+	}
+
+	void Draw() const override {
+		Vector2 dir = (velocity.x == 0.f && velocity.y == 0.f) ? Vector2{ 0, -1 } : Vector2Normalize(velocity);
+		Vector2 side = { -dir.y, dir.x };
+		float r = RADIUS;
+		Vector2 nose = Vector2Add(transform.position, Vector2Scale(dir, r));
+		Vector2 back = Vector2Subtract(transform.position, Vector2Scale(dir, r * 0.6f));
+		Renderer::Instance().Queue().Triangle(nose, Vector2Subtract(back, Vector2Scale(side, r * 0.7f)), Vector2Add(back, Vector2Scale(side, r * 0.7f)), color);
+	}
+
+	float GetRadius() const override {
+		return RADIUS;
+	}
+
+	Vector2 GetVelocity() const {
+		return velocity;
+	}
+
+	// Re-plans on ticks where (tick + phase) % REPLAN_TICKS == 0
+	bool PlansOn(uint32_t tick) const {
+		return (tick + phase) % REPLAN_TICKS == 0;
+	}
+
+	void Plan(const FlockIndex& index, Vector2 target) {
+		FlockSums s = index.Query(transform.position, FLOCK.neighbourRadius, FLOCK.separationRadius);
+		accel = FlockSteer(transform.position, velocity, s, target, FLOCK);
+	}
+
+	static constexpr FlockParams FLOCK{};
+	static constexpr uint32_t REPLAN_TICKS = 4;
+	static constexpr float RADIUS = 10.f;
+	static constexpr int DAMAGE = 4;
+	static constexpr int SCORE = 5;
+
+private:
+	Vector2 velocity;
+	Vector2 accel{};
+	uint32_t phase;
+	Color color;
 };
 
 class Heart {
@@ -526,48 +1029,208 @@ public:
 
 	static void LoadAssets() {
 		if (!loaded) {
-			heartTex = LoadTexture("cake.png");
-			heartTexNightmare = LoadTexture("heart.png");
-			SetTextureFilter(heartTex, TEXTURE_FILTER_BILINEAR);
-			SetTextureFilter(heartTexNightmare, TEXTURE_FILTER_BILINEAR);
+			heartTex = Renderer::Instance().LoadSprite("cake.png", TEXTURE_FILTER_BILINEAR, false);
+			heartTexNightmare = Renderer::Instance().LoadSprite("heart.png", TEXTURE_FILTER_BILINEAR, false);
 			loaded = true;
 		}
 	}
 
 	static void UnloadAssets() {
 		if (loaded) {
-			UnloadTexture(heartTex);
-			UnloadTexture(heartTexNightmare);
+			Renderer::Instance().UnloadSprite(heartTex);
+			Renderer::Instance().UnloadSprite(heartTexNightmare);
 			loaded = false;
 		}
 	}
 
-	bool Update(float dt) {
+	void Update(float dt) {
 		position = Vector2Add(position, Vector2Scale(velocity, dt));
-		return position.y > Renderer::Instance().Height();
+	}
+
+	// Seconds until the heart falls out through the bottom of 'box'
+	float ExitTime(Rectangle box) const {
+		return Utils::ExitTime(position, velocity, { -INFINITY, -INFINITY }, { INFINITY, box.y + box.height });
+	}
+
+	void MoveBy(Vector2 offset) {
+		position = Vector2Add(position, offset);
 	}
 
 	void Draw(bool nightmare) const {
 		float usedScale = nightmare ? scale : scale * 1.4f;
 		Texture2D tex = nightmare ? heartTexNightmare : heartTex;
 		Vector2 drawPos = { position.x - tex.width / 2.0f * usedScale, position.y - tex.height / 2.0f * usedScale };
-		DrawTextureEx(tex, drawPos, 0.0f, usedScale, WHITE);
+		Renderer::Instance().Queue().Texture(tex, drawPos, 0.0f, usedScale, WHITE);
 
 	}
 
 	Vector2 GetPosition() const { return position; }
-	float GetRadius() const { return (heartTex.width * scale) / 2.0f; }
+	float GetRadius() const { return Radius(); }
+	static float Radius() { return (heartTex.width * scale) / 2.0f; }
+
+	uint32_t GetHandle() const { return handle; }
+	void SetHandle(uint32_t h) { handle = h; }
+
+	uint32_t GetExitTick() const { return exitTick; }
+	void SetExitTick(uint32_t t) { exitTick = t; }
 
 private:
 	Vector2 position;
 	Vector2 velocity;
+	uint32_t handle = HandleMap::INVALID;
+	uint32_t exitTick = 0; // the scheduled exit that still counts
 	inline static Texture2D heartTex;
 	inline static Texture2D heartTexNightmare;
 	inline static bool loaded = false;
 	static constexpr float scale = 0.07f;
 };
 
+void DetectPlayerHits(const Ship& player, const std::vector<std::unique_ptr<Asteroid>>& asteroids,
+	const std::vector<uint8_t>& asteroidGone, int begin, int end, EventBuffer& out)
+{
+	if (!player.IsAlive()) return;
+	for (int i = begin; i < end; ++i) {
+		if (asteroidGone[i]) continue;
+		float dist = Vector2Distance(player.GetPosition(), asteroids[i]->GetPosition());
+		if (dist < player.GetRadius() + asteroids[i]->GetRadius()) {
+			out.Push(GameEventType::PLAYER_HIT, i, 0, asteroids[i]->GetDamage(), EntityKind::ASTEROID);
+		}
+	}
+}
+
+void AdvanceHearts(std::vector<Heart>& hearts, float dt, int begin, int end) {
+	for (int i = begin; i < end; ++i) {
+		hearts[i].Update(dt);
+	}
+}
+
+void DrawHearts(const std::vector<Heart>& hearts, Rectangle view, bool nightmare) {
+	for (const Heart& heart : hearts) {
+		if (Utils::Overlaps(heart.GetPosition(), heart.GetRadius(), view)) heart.Draw(nightmare);
+	}
+}
+
+void DetectHeartPickups(const Ship& player, const std::vector<Heart>& hearts, const std::vector<uint8_t>& heartGone,
+	int heal, int begin, int end, EventBuffer& out)
+{
+	for (int i = begin; i < end; ++i) {
+		if (heartGone[i]) continue;
+		float dist = Vector2Distance(player.GetPosition(), hearts[i].GetPosition());
+		if (dist < player.GetRadius() + hearts[i].GetRadius()) {
+			out.Push(GameEventType::HEART_COLLECTED, i, 0, heal);
+		}
+	}
+}
+
+// Steering from 'index' (the swarm as of the last tick), then one step for everyone
+void AdvanceEnemies(std::vector<EnemyShip>& enemies, const FlockIndex& index, Vector2 target, uint32_t tick, float dt,
+	int begin, int end)
+{
+	for (int i = begin; i < end; ++i) {
+		if (enemies[i].PlansOn(tick)) enemies[i].Plan(index, target);
+		enemies[i].Update(dt);
+	}
+}
+
+void IndexEnemies(const std::vector<EnemyShip>& enemies, FlockIndex& index) {
+	index.Build(enemies.size(), EnemyShip::FLOCK.neighbourRadius, [&](size_t i, Vector2& p, Vector2& v) {
+		p = enemies[i].GetPosition();
+		v = enemies[i].GetVelocity();
+	});
+}
+
+void DetectEnemyContacts(const Ship& player, const FlockIndex& enemies, EventBuffer& out) {
+	if (!player.IsAlive()) return;
+	enemies.ForEachNear(player.GetPosition(), player.GetRadius() + EnemyShip::RADIUS, [&](uint32_t id) {
+		out.Push(GameEventType::PLAYER_HIT, id, 0, EnemyShip::DAMAGE, EntityKind::ENEMY);
+	});
+}
+
+template<WeaponType W>
+void DetectEnemyHits(const std::vector<Shot>& shots, const std::vector<uint8_t>& shotGone,
+	const FlockIndex& enemies, int begin, int end, EventBuffer& out)
+{
+	if (enemies.Size() == 0) return;
+	for (int i = begin; i < end; ++i) {
+		if (shotGone[i]) continue;
+		enemies.ForEachNear(shots[i].position, Weapon(W).radius + EnemyShip::RADIUS, [&](uint32_t id) {
+			out.Push(GameEventType::ENEMY_DESTROYED, ShotId(W, i), id, EnemyShip::SCORE);
+		});
+	}
+}
+
 // --- APPLICATION ---
+// Balance knobs; BatchRun sweeps them. The defaults are the game as shipped.
+// What the HUD shows this frame
+struct HudState {
+	int hp = Ship::MAX_HP;
+	int score = 0;
+	float boostCharge = 0.f;
+	bool boostReady = false;
+	WeaponType weapon = WeaponType::LASER;
+	bool nightmare = false;
+	bool alive = true;
+	float time = 0.f; // blinks the nightmare banner
+};
+
+// Queued on the HUD layer after Composite(), so the projectile lights do not tint it
+void DrawHud(const HudState& hud) {
+	RenderQueue& queue = Renderer::Instance().Queue();
+	int w = Renderer::Instance().Width();
+	int h = Renderer::Instance().Height();
+	queue.SetLayer(RenderLayer::HUD);
+	if (hud.nightmare && fmodf(hud.time, 1.0f) < 0.5f) {
+		const char* nightmareText = "NIGHTMARE MODE";
+		int textWidth = MeasureText(nightmareText, 40);
+		queue.Text(nightmareText,
+			(w - textWidth) / 2,
+			100,
+			40,
+			RED);
+	}
+	if(hud.nightmare) queue.Text(TextFormat("HP: %d", hud.hp),10, 10, 20, GREEN);
+	else queue.Text(TextFormat("BEAUTY: %d", hud.hp),10, 10, 20, PINK);
+
+	if (!hud.alive) {
+		queue.Text("GAME OVER", w / 2 - MeasureText("GAME OVER", 40) / 2, h / 2 - 40, 40, RED);
+		queue.Text("Press R to restart", w / 2 - MeasureText("Press R to restart", 20) / 2, h / 2 + 10, 20, DARKGRAY);
+		queue.Text(TextFormat("Score: %d", hud.score), w / 2 - MeasureText(TextFormat("Score: %d", hud.score), 20) / 2, h / 2 + 40, 20, BLACK);
+
+	}
+	const char* weaponName = hud.nightmare ? Weapon(hud.weapon).nightmareName : Weapon(hud.weapon).name;
+	queue.Text(TextFormat("Power: %s", weaponName),
+		10, 40, 20, BLUE);
+
+	queue.Text(TextFormat("Score: %d", hud.score), 10, 70, 20, YELLOW);
+
+	queue.Text("Power Boost", 10, 130, 20, RAYWHITE);
+	queue.Rect({ 10, 160, 200, 20 }, GRAY); // tło paska
+	queue.Rect({ 10, 160, floorf(200 * hud.boostCharge), 20 }, RED); // poziom naładowania
+
+	if (hud.boostReady) {
+		queue.Text("PRESS J TO UNLEASH!", 10, 190, 20, YELLOW);
+	}
+}
+
+struct GameRules {
+	float spawnMin = 0.5f;   // seconds between asteroid spawns, halved in nightmare
+	float spawnMax = 3.0f;
+	float heartMin = 12.0f;  // seconds between hearts
+	float heartMax = 15.0f;
+	int heartHeal = 40;
+	int nightmareScore = 200;
+	bool swarms = true;      // BatchRun leaves them out
+};
+
+struct RunOptions {
+	const char* replayPath = nullptr; // play back a hitch capture instead of the keyboard
+	float hitchBudgetMs = 0.f;        // 0: twice the target frame period
+	bool hitchCapture = true;
+	int captureScale = 2;             // screenshots and clips are 1/n of the window size
+	bool record = false;              // GIF clip from the first frame to exit
+	int worldAsteroids = 10'000;      // population of the whole world, ~40 per screen
+};
+
 class Application {
 public:
 	static Application& Instance() {
@@ -575,318 +1238,808 @@ public:
 		return inst;
 	}
 	
-	void Run() {
-		bool paused = false;
-		srand(static_cast<unsigned>(time(nullptr)));
+	void Run(const RunOptions& options = {}) {
+		HitchCapture replay;
+		bool replaying = options.replayPath != nullptr;
+		if (replaying && !LoadReplay(options.replayPath, replay)) return;
+
 		Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Unicorns OOP");
-		Projectile::LoadAssets();
+		ShotSprites::Load();
 		Heart::LoadAssets();
-		auto player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
+		events.Reserve(JobPool::Instance().Workers());
+		if (!replaying && !metrics.Open()) {
+			TraceLog(LOG_WARNING, "Metrics segment unavailable, running without live metrics");
+		}
 
-		float spawnTimer = 0.f;
-		float spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-		WeaponType currentWeapon = WeaponType::LASER;
-		float shotTimer = 0.f;
+		ScreenRecorder& recorder = Renderer::Instance().Recorder();
+		RenderQueue& queue = Renderer::Instance().Queue();
+		if (!recorder.Init(options.captureScale)) {
+			TraceLog(LOG_WARNING, "Screen recorder unavailable, no screenshots or clips");
+		}
+		if (options.record) {
+			recorder.StartRecording();
+		}
 
-		bool nightmareMode = false;
+		FramePacer& pacer = Renderer::Instance().Pacer();
+		double budget = options.hitchBudgetMs > 0.f ? options.hitchBudgetMs / 1000.0 : 2.0 * pacer.Period();
+		hitch.Init(budget, options.hitchCapture && !replaying, static_cast<uint32_t>(time(nullptr)));
+		if (replaying) {
+			pacer.SetMode(PacingMode::UNCAPPED); // dt comes from the capture
+			Utils::Rng().SetState(replay.header.replayRng);
+		}
+		else {
+			Utils::Rng().Seed(static_cast<uint64_t>(time(nullptr)));
+		}
+		worldAsteroids = replaying ? static_cast<int>(replay.header.replayConfig) : options.worldAsteroids;
+		ResetGame();
 
-		float boostCooldown = 0.0f; 
-		
+		size_t replayFrame = 0;
 		while (!WindowShouldClose()) {
-			float dt = GetFrameTime();
-			spawnTimer += dt;
+			float dt = Renderer::Instance().BeginFrame();
+			InputFrame in = ReadInput(dt);
+			if (replaying) {
+				if (replayFrame == replay.inputs.size()) {
+					hitch.BeginFrame(pacer.LastFrameSeconds(), in, Utils::Rng().State()); // closes the last record
+					break;
+				}
+				in = replay.inputs[replayFrame++];
+			}
+			hitch.BeginFrame(pacer.LastFrameSeconds(), in, Utils::Rng().State());
 
-			if (IsKeyPressed(KEY_P)) {
-				paused = !paused;
+			if (in.Pressed(BTN_PACING) && !replaying) {
+				pacer.CycleMode();
+			}
+			if (in.Pressed(BTN_OVERLAY)) {
+				showLatency = !showLatency;
+			}
+			if (in.Pressed(BTN_SDF)) {
+				sdfOutlines = !sdfOutlines;
 			}
-			if (!paused)
+			if (in.Pressed(BTN_SORT)) {
+				queue.SetSorting(!queue.Sorting());
+			}
+			// F12 screenshot (SHIFT: QOI), CTRL+F12 starts/stops a GIF clip
+			if (in.Pressed(BTN_CAPTURE) && !replaying) {
+				if (!in.Down(BTN_MOD_CTRL)) recorder.Screenshot(in.Down(BTN_MOD_SHIFT) ? CaptureFormat::QOI : CaptureFormat::PNG);
+				else if (recorder.IsRecording()) recorder.StopRecording();
+				else recorder.StartRecording();
+			}
+			Tick(in);
+			hitch.SetCounts(asteroids.size(), ShotCount(shots), hearts.size());
+
+			// Render everything
 			{
-				if (!nightmareMode && score >= 200) {
-					nightmareMode = true;
-					player->EnableNightmareMode();
+				FrameOverlay overlay;
+				overlay.time = static_cast<float>(GetTime());
+				overlay.nightmare = nightmareMode;
+				overlay.flash = flashAmount;
+				overlay.dim = paused ? 0.5f : 0.0f;
+				Renderer::Instance().Begin(overlay);
+
+				// World: only what overlaps the view
+				Rectangle view = ViewBounds();
+				LightTiles& lights = Renderer::Instance().Lights();
+				lights.Clear();
+				ForEachWeapon([&](auto w) {
+					constexpr WeaponType W = decltype(w)::value;
+					AddShotLights<W>(shots[static_cast<int>(W)], view, nightmareMode, lights);
+				});
+				lights.Bin();
+				Renderer::Instance().BeginWorld(camera);
+				DrawSectorGrid(view, world.SectorSize(), world.Columns(), world.Rows());
+				queue.SetLayer(RenderLayer::WORLD);
+				DrawHearts(hearts, view, nightmareMode);
+				ForEachWeapon([&](auto w) {
+					constexpr WeaponType W = decltype(w)::value;
+					DrawShots<W>(shots[static_cast<int>(W)], view, nightmareMode, overlay.time);
+				});
+				if (sdfOutlines && Renderer::Instance().Sdf().IsReady()) {
+					AsteroidSdfRenderer& sdf = Renderer::Instance().Sdf();
+					for (const auto& astPtr : asteroids) {
+						if (!Utils::Overlaps(astPtr->GetPosition(), astPtr->GetRadius(), view)) continue;
+						if (!astPtr->DrawSdf(sdf)) astPtr->Draw();
+					}
+					queue.Flush(); // the instanced outlines go on top of what is queued so far
+					sdf.Flush();
 				}
-
-				// Update player
-				player->Update(dt);
-
-				heartSpawnTimer += dt;
-				if (heartSpawnTimer >= heartSpawnInterval) {
-					hearts.emplace_back(C_WIDTH, C_HEIGHT);
-					heartSpawnTimer = 0.0f;
-					heartSpawnInterval = Utils::RandomFloat(12.0f, 15.0f); 				}
-
-				//kolizja serc z graczem
-				auto heart_it = hearts.begin();
-				while (heart_it != hearts.end()) {
-					if (heart_it->Update(dt)) {
-						heart_it = hearts.erase(heart_it); // wypadło poza ekran
-						continue;
+				else {
+					for (const auto& astPtr : asteroids) {
+						if (Utils::Overlaps(astPtr->GetPosition(), astPtr->GetRadius(), view)) astPtr->Draw();
 					}
+				}
+				for (const EnemyShip& enemy : enemies) {
+					if (Utils::Overlaps(enemy.GetPosition(), enemy.GetRadius(), view)) enemy.Draw();
+				}
+				queue.SetLayer(RenderLayer::PLAYER);
+				player->Draw();
+				Renderer::Instance().EndWorld();
+
+				// The HUD goes on top of the finished frame, out of the lights, flash and dim
+				Renderer::Instance().Composite();
+
+				HudState hud;
+				hud.hp = player->GetHP();
+				hud.score = score;
+				hud.boostCharge = boostCharge;
+				hud.boostReady = powerBoostAvailable;
+				hud.weapon = currentWeapon;
+				hud.nightmare = nightmareMode;
+				hud.alive = player->IsAlive();
+				hud.time = overlay.time;
+				DrawHud(hud);
 
-					float dist = Vector2Distance(player->GetPosition(), heart_it->GetPosition());
-					if (dist < player->GetRadius() + heart_it->GetRadius()) {
-						if (player->IsAlive() && player->GetHP() < 100) {
-							int missing = 100 - player->GetHP();
-							player->TakeDamage(-std::min(40, missing)); // lecz tylko brakujące
-						}
+				if (paused) {
+					queue.Text("PAUSED", C_WIDTH / 2 - 50, C_HEIGHT / 2, 40, RAYWHITE);
+				}
 
-						heart_it = hearts.erase(heart_it);
+				if (showLatency) {
+					const FramePacer& pacer = Renderer::Instance().Pacer();
+					const LatencyHistogram& lat = pacer.Latency();
+					queue.Text(TextFormat("Pacing: %s (F2)", PacingModeName(pacer.Mode())), C_WIDTH - 320, 10, 20, DARKGREEN);
+					queue.Text(TextFormat("Input->present p50 %.2f ms  p99 %.2f ms", lat.PercentileMs(0.5), lat.PercentileMs(0.99)),
+						C_WIDTH - 420, 40, 20, DARKGREEN);
+					for (int i = 0; i < EventQueue::TYPES; ++i) {
+						GameEventType type = static_cast<GameEventType>(i);
+						queue.Text(TextFormat("%s: %llu", GameEventName(type), (unsigned long long)events.TotalCount(type)),
+							C_WIDTH - 320, 70 + i * 20, 20, DARKGREEN);
 					}
-					else {
-						++heart_it;
+					if (recorder.IsReady()) {
+						queue.Text(TextFormat("Capture %.2f ms (max %.2f)  dropped %llu", recorder.LastCostMs(), recorder.MaxCostMs(),
+							(unsigned long long)recorder.Dropped()), C_WIDTH - 420, 70 + EventQueue::TYPES * 20, 20, DARKGREEN);
 					}
+					queue.Text(TextFormat("World: %zu awake, %zu asleep, %zu enemies", asteroids.size(), world.Sleeping(), enemies.size()),
+						C_WIDTH - 420, 90 + EventQueue::TYPES * 20, 20, DARKGREEN);
+					queue.Text(TextFormat("Lights: %zu in view, %zu dropped from full tiles", lights.Count(), lights.Dropped()),
+						C_WIDTH - 420, 110 + EventQueue::TYPES * 20, 20, DARKGREEN);
+					const Renderer::FrameStats& draws = Renderer::Instance().LastFrame();
+					queue.Text(TextFormat("Draw calls: %llu  %zu commands  %zu switches  %s (F5)", (unsigned long long)draws.drawCalls,
+						draws.commands, draws.stateChanges, queue.Sorting() ? "sorted" : "unsorted"), C_WIDTH - 420, 130 + EventQueue::TYPES * 20, 20, DARKGREEN);
 				}
+				hitch.Mark(FramePhase::RENDER);
+				Renderer::Instance().End();
+				hitch.Mark(FramePhase::PRESENT);
+			}
+			PublishMetrics(dt, nightmareMode, paused);
+		}
+		if (replaying) {
+			ReportReplay(replay);
+		}
+		else {
+			ReportFrameTimes();
+		}
+		metrics.Close();
+		scripts.Clear();
+		Heart::UnloadAssets();
+		ShotSprites::Unload();
+		player.reset();
+		Renderer::Instance().Shutdown();
+	}
 
-				// Power Boost: usuń wszystkie asteroidy
-				if (IsKeyPressed(KEY_J) && powerBoostAvailable) {
-					flashActive = true;
-					flashTimer = 0.2f;
-					asteroids.clear();
-					powerBoostAvailable = false;
-					boostCharge = 0.0f; 
-				}
+	// --- Headless ---
+	// A game driven without Run()'s loop, for BatchRun's parity check. The textures still
+	// load, so this needs a GL context; a hidden window will do.
+	void StartGame(const GameRules& gameRules, uint64_t seed, int population) {
+		Heart::LoadAssets();
+		events.Reserve(JobPool::Instance().Workers());
+		rules = gameRules;
+		worldAsteroids = population;
+		Utils::Rng().Seed(seed);
+		ResetGame();
+	}
 
-				// Restart logic
-				if (!player->IsAlive() && IsKeyPressed(KEY_R)) {
-					player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
-					score = 0;
-					boostCharge = 0.0f;
-					nightmareMode = false;
-					asteroids.clear();
-					projectiles.clear();
-					spawnTimer = 0.f;
-					spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-				}
-				// Asteroid shape switch
-				if (IsKeyPressed(KEY_ONE)) {
-					currentShape = AsteroidShape::TRIANGLE;
-				}
-				if (IsKeyPressed(KEY_TWO)) {
-					currentShape = AsteroidShape::SQUARE;
-				}
-				if (IsKeyPressed(KEY_THREE)) {
-					currentShape = AsteroidShape::PENTAGON;
-				}
-				if (IsKeyPressed(KEY_FOUR)) {
-					currentShape = AsteroidShape::RANDOM;
-				}
+	// One frame of gameplay, as Run() does it after reading the input
+	void Step(const InputFrame& in) {
+		Tick(in);
+	}
 
+	void StopGame() {
+		scripts.Clear();
+		Heart::UnloadAssets();
+		player.reset();
+	}
 
-				// Weapon switch
-				if (IsKeyPressed(KEY_TAB)) {
-					currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
-				}
+	int Score() const { return score; }
+	int PlayerHP() const { return player->GetHP(); }
+	float PlayerRadius() const { return player->GetRadius(); }
 
-				// Shooting
-				{
-					if (player->IsAlive() && IsKeyDown(KEY_SPACE)) {
-						shotTimer += dt;
-						float interval = 1.f / player->GetFireRate(currentWeapon);
-						float projSpeed = player->GetSpacing(currentWeapon) * player->GetFireRate(currentWeapon);
-
-						while (shotTimer >= interval) {
-							Vector2 p = player->GetPosition();
-							p.y -= player->GetRadius();
-							projectiles.push_back(MakeProjectile(currentWeapon, p, projSpeed, nightmareMode));
-							shotTimer -= interval;
-						}
-					}
-					else {
-						float maxInterval = 1.f / player->GetFireRate(currentWeapon);
+private:
+	// --- World ---
+	Rectangle ViewBounds() const {
+		return { camera.target.x - camera.offset.x, camera.target.y - camera.offset.y, (float)C_WIDTH, (float)C_HEIGHT };
+	}
 
-						if (shotTimer > maxInterval) {
-							shotTimer = fmodf(shotTimer, maxInterval);
-						}
-					}
-				}
+	// Camera on the player, stopping at the world edges
+	void FollowPlayer() {
+		Vector2 half = camera.offset;
+		camera.target = Vector2Clamp(player->GetPosition(), half, Vector2Subtract(world.WorldSize(), half));
+	}
 
-				// Spawn asteroids
-				if (spawnTimer >= spawnInterval && asteroids.size() < MAX_AST) {
-					asteroids.push_back(MakeAsteroid(C_WIDTH, C_HEIGHT, currentShape, nightmareMode));
-					spawnTimer = 0.f;
-					spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-				}
+	// How sleepers catch up when they are looked at again
+	auto Drifter() {
+		return [size = world.WorldSize()](std::unique_ptr<Asteroid>& a, float seconds) { a->Drift(seconds, size); };
+	}
 
-				if (nightmareMode) {
-					spawnInterval = Utils::RandomFloat(C_SPAWN_MIN * 0.5f, C_SPAWN_MAX * 0.5f);
-				}
+	size_t AsteroidsInView() const {
+		Rectangle view = ViewBounds();
+		size_t n = 0;
+		for (const auto& a : asteroids) {
+			if (Utils::Overlaps(a->GetPosition(), a->GetRadius(), view)) n++;
+		}
+		return n;
+	}
 
-				// Update projectiles - check if in boundries and move them forward
-				{
-					auto projectile_to_remove = std::remove_if(projectiles.begin(), projectiles.end(),
-						[dt](auto& projectile) {
-							return projectile.Update(dt);
-						});
-					projectiles.erase(projectile_to_remove, projectiles.end());
-				}
+	void WakeAsteroids() {
+		for (auto& a : woken) AddAsteroid(std::move(a));
+		woken.clear();
+	}
 
-				// Projectile-Asteroid collisions O(n^2)
-				for (auto pit = projectiles.begin(); pit != projectiles.end();) {
-					bool removed = false;
-
-					for (auto ait = asteroids.begin(); ait != asteroids.end(); ++ait) {
-						float dist = Vector2Distance((*pit).GetPosition(), (*ait)->GetPosition());
-						if (dist < (*pit).GetRadius() + (*ait)->GetRadius()) {
-							score += (*ait)->GetSize() * 10;
-							boostCharge += (*ait)->GetSize() * 10.0f / 300.0f;
-							if (boostCharge >= 1.0f) {
-								boostCharge = 1.0f;
-								powerBoostAvailable = true;
-							}
-
-							ait = asteroids.erase(ait);
-							pit = projectiles.erase(pit);
-							removed = true;
-							break;
-						}
-					}
-					if (!removed) {
-						++pit;
-					}
-				}
+	// Moves the awake window with the camera and hands back the sleepers that reach it.
+	// Every sleeper is caught up at least once per C_SLEEP_REFRESH, which is shorter than the
+	// fastest asteroid needs to cross the gap between the view and the window's edge.
+	void StepWorld(float dt) {
+		FollowPlayer();
+		double now = simTime; // woken asteroids are moved by this frame's Simulate()
+		if (world.SetActive(world.SectorOf(camera.target), C_ACTIVE_RADIUS, now, Drifter(), woken)) {
+			// Exits were scheduled against the old window. Simulate() skips the stale ones.
+			Rectangle bounds = world.ActiveBounds();
+			for (const auto& a : asteroids) {
+				a->SetExitTick(ScheduleExit(EntityKind::ASTEROID, a->GetHandle(), a->ExitTime(bounds)));
+			}
+			for (Heart& h : hearts) {
+				h.SetExitTick(ScheduleExit(EntityKind::HEART, h.GetHandle(), h.ExitTime(bounds)));
+			}
+		}
+		size_t budget = static_cast<size_t>(world.Sleeping() * dt / C_SLEEP_REFRESH) + 1;
+		world.Refresh(now, budget, Drifter(), woken);
+		WakeAsteroids();
+	}
 
-				// Asteroid-Ship collisions
-				{
-					auto remove_collision =
-						[&player, dt](auto& asteroid_ptr_like) -> bool {
-						if (player->IsAlive()) {
-							float dist = Vector2Distance(player->GetPosition(), asteroid_ptr_like->GetPosition());
-
-							if (dist < player->GetRadius() + asteroid_ptr_like->GetRadius()) {
-								player->TakeDamage(asteroid_ptr_like->GetDamage());
-								return true; // Mark asteroid for removal due to collision
-							}
-						}
-						if (!asteroid_ptr_like->Update(dt)) {
-							return true;
-						}
-						return false; // Keep the asteroid
-						};
-					auto asteroid_to_remove = std::remove_if(asteroids.begin(), asteroids.end(), remove_collision);
-					asteroids.erase(asteroid_to_remove, asteroids.end());
+	// One frame of gameplay. Reads nothing but 'in' and the game RNG, which is what makes
+	// hitch captures replayable.
+	void Tick(const InputFrame& in) {
+		if (in.Pressed(BTN_PAUSE)) {
+			paused = !paused;
+		}
+		if (paused) return;
+		float dt = in.dt;
+
+		if (!nightmareMode && score >= rules.nightmareScore) {
+			nightmareMode = true;
+			player->EnableNightmareMode();
+		}
+
+		// Update player
+		player->Steer(in);
+		player->Update(dt);
+		player->ClampTo({ 0, 0 }, world.WorldSize());
+		StepWorld(dt);
+
+		// Power Boost: usuń wszystkie asteroidy
+		if (in.Pressed(BTN_BOOST) && powerBoostAvailable) {
+			events.Buffer(0).Push(GameEventType::BOOST_FIRED, 0);
+		}
+
+		// Restart logic
+		if (!player->IsAlive() && in.Pressed(BTN_RESTART)) {
+			ResetGame();
+			return;
+		}
+		// Asteroid shape switch
+		if (in.Pressed(BTN_SHAPE_1)) {
+			currentShape = AsteroidShape::TRIANGLE;
+		}
+		if (in.Pressed(BTN_SHAPE_2)) {
+			currentShape = AsteroidShape::SQUARE;
+		}
+		if (in.Pressed(BTN_SHAPE_3)) {
+			currentShape = AsteroidShape::PENTAGON;
+		}
+		if (in.Pressed(BTN_SHAPE_4)) {
+			currentShape = AsteroidShape::RANDOM;
+		}
+
+		// Weapon switch
+		if (in.Pressed(BTN_WEAPON)) {
+			currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
+		}
+
+		// Shooting
+		{
+			if (player->IsAlive() && in.Down(BTN_FIRE)) {
+				shotTimer += dt;
+				float interval = 1.f / Weapon(currentWeapon).fireRate;
+
+				while (shotTimer >= interval) {
+					Vector2 p = player->GetPosition();
+					p.y -= player->GetRadius();
+					FireShot(currentWeapon, p);
+					shotTimer -= interval;
 				}
 			}
+			else {
+				float maxInterval = 1.f / Weapon(currentWeapon).fireRate;
 
-			// Render everything
-			{
-				Renderer::Instance().Begin();
-				if (flashActive) {
-					flashTimer -= GetFrameTime();
-					if (flashTimer <= 0.0f) {
-						flashActive = false;
-					}
-					else {
-						DrawRectangle(0, 0, C_WIDTH, C_HEIGHT, WHITE); // pełny biały ekran
-					}
+				if (shotTimer > maxInterval) {
+					shotTimer = fmodf(shotTimer, maxInterval);
 				}
+			}
+		}
 
-				for (const auto& heart : hearts) {
-					heart.Draw(nightmareMode);
-				}
+		// Spawners, flash and other timed scripts
+		scripts.Update(dt);
+		hitch.Mark(FramePhase::UPDATE);
 
-				if (nightmareMode) {
-					ClearBackground(DARKGRAY);
-					float flashAlpha = (sinf(GetTime() * 10) * 0.5f + 0.5f) * 0.3f;
-					DrawRectangle(0, 0, C_WIDTH, C_HEIGHT, Fade(RED, flashAlpha));
-		
-					if (fmodf(GetTime(), 1.0f) < 0.5f) {
-						const char* nightmareText = "NIGHTMARE MODE";
-						int textWidth = MeasureText(nightmareText, 40);
-						DrawText(nightmareText,
-							(C_WIDTH - textWidth) / 2,
-							100,
-							40,
-							RED);
-					}
-				}
-				else {
-					float t = GetTime() * 0.5f;
-					Color bg = {
-						(unsigned char)(150 + 50 * sinf(t)),
-						(unsigned char)(200 + 50 * sinf(t + 2)),
-						(unsigned char)(230 + 25 * sinf(t + 4)),
-						255
-					};
-					ClearBackground(bg);
-				}
-				if(nightmareMode) DrawText(TextFormat("HP: %d", player->GetHP()),10, 10, 20, GREEN);
-				else DrawText(TextFormat("BEAUTY: %d", player->GetHP()),10, 10, 20, PINK);
+		Simulate(dt);
+		hitch.Mark(FramePhase::SIMULATE);
+		ResolveEvents();
+		hitch.Mark(FramePhase::RESOLVE);
+	}
 
-				if (!player->IsAlive()) {
-					DrawText("GAME OVER", C_WIDTH / 2 - MeasureText("GAME OVER", 40) / 2, C_HEIGHT / 2 - 40, 40, RED);
-					DrawText("Press R to restart", C_WIDTH / 2 - MeasureText("Press R to restart", 20) / 2, C_HEIGHT / 2 + 10, 20, DARKGRAY);
-					DrawText(TextFormat("Score: %d", score), C_WIDTH / 2 - MeasureText(TextFormat("Score: %d", score), 20) / 2, C_HEIGHT / 2 + 40, 20, BLACK);
+	// New game from scratch. From here on the game depends only on the RNG state and the
+	// input, so this is also where replays start.
+	void ResetGame() {
+		hitch.BeginSegment(Utils::Rng().State(), static_cast<uint32_t>(worldAsteroids));
+		scripts.Reset();
+		events.Discard();
+		asteroids.clear();
+		for (auto& s : shots) s.clear();
+		hearts.clear();
+		enemies.clear();
+		IndexEnemies(enemies, enemyIndex);
+		asteroidHandles = HandleMap();
+		heartHandles = HandleMap();
+		exits.Reset(0);
+		simTime = 0.0;
+		world.Clear();
+
+		Vector2 size = world.WorldSize();
+		player = std::make_unique<PlayerShip>(static_cast<int>(size.x), static_cast<int>(size.y));
+		score = 0;
+		powerBoostAvailable = false;
+		boostCharge = 0.0f;
+		flashAmount = 0.0f;
+		nightmareMode = false;
+		paused = false;
+		currentShape = AsteroidShape::TRIANGLE;
+		currentWeapon = WeaponType::LASER;
+		shotTimer = 0.f;
+
+		// Scatter the world population, then wake the sectors around the player
+		for (int i = 0; i < worldAsteroids; ++i) {
+			std::unique_ptr<Asteroid> a = MakeAsteroid(C_WIDTH, C_HEIGHT, AsteroidShape::RANDOM);
+			a->MoveBy({ Utils::RandomFloat(0, size.x - C_WIDTH), Utils::RandomFloat(0, size.y - C_HEIGHT) });
+			a->Drift(0.f, size);
+			world.Sleep(std::move(a), simTime, woken);
+		}
+		FollowPlayer();
+		world.SetActive(world.SectorOf(camera.target), C_ACTIVE_RADIUS, simTime, Drifter(), woken);
+		WakeAsteroids();
 
-				}
-				const char* weaponName;
-				if(nightmareMode) weaponName = (currentWeapon == WeaponType::LASER) ? "DEATH" : "TREMOR";
-				else weaponName = (currentWeapon == WeaponType::LASER) ? "LOVE" : "FRIENDSHIP";
-				DrawText(TextFormat("Power: %s", weaponName),
-					10, 40, 20, BLUE);
+		scripts.Start(AsteroidSpawner(), SCOPE_ASTEROIDS);
+		scripts.Start(HeartSpawner(), SCOPE_GAME);
+		if (rules.swarms) scripts.Start(SwarmSpawner(), SCOPE_GAME);
+	}
 
-				DrawText(TextFormat("Score: %d", score), 10, 70, 20, YELLOW);
+	bool LoadReplay(const char* path, HitchCapture& capture) {
+		if (!capture.Load(path)) {
+			TraceLog(LOG_ERROR, "REPLAY: %s is not a hitch capture from this build", path);
+			return false;
+		}
+		if (capture.inputs.empty()) {
+			// The input log ran over HitchDetector::MAX_REPLAY_FRAMES, only the timings are left
+			TraceLog(LOG_WARNING, "REPLAY: %s has no input log, recorded timings only", path);
+			for (const FrameRecord& r : capture.records) LogFrameRecord("recorded", r);
+			return false;
+		}
+		return true;
+	}
 
-				DrawText("Power Boost", 10, 130, 20, RAYWHITE);
-				DrawRectangle(10, 160, 200, 20, GRAY); // tło paska
-				DrawRectangle(10, 160, (int)(200 * boostCharge), 20, RED); // poziom naładowania
+	static void LogFrameRecord(const char* label, const FrameRecord& r) {
+		TraceLog(LOG_INFO, "%-8s frame %6u %7.2f ms | update %6.2f sim %6.2f resolve %6.2f render %6.2f present %6.2f | ast %u proj %u",
+			label, r.frame, r.frameMs, r.phaseMs[0], r.phaseMs[1], r.phaseMs[2], r.phaseMs[3], r.phaseMs[4], r.asteroids, r.projectiles);
+	}
 
-				if (powerBoostAvailable) {
-					DrawText("PRESS J TO UNLEASH!", 10, 190, 20, YELLOW);
-				}
-		
-				for (const auto& projPtr : projectiles) {
-					projPtr.Draw();
-				}
-				for (const auto& astPtr : asteroids) {
-					astPtr->Draw();
-				}
+	// Recorded vs replayed timings of the frames before the hitch. The RNG state at the start of
+	// every frame has to match; if it doesn't, the capture is from a different build.
+	void ReportReplay(const HitchCapture& capture) {
+		size_t compared = 0;
+		size_t diverged = 0;
+		for (const FrameRecord& r : capture.records) {
+			const FrameRecord* p = hitch.Find(r.frame);
+			if (!p) continue;
+			compared++;
+			if (p->rngState != r.rngState) diverged++;
+		}
+		size_t first = capture.records.size() > C_REPLAY_REPORT_FRAMES ? capture.records.size() - C_REPLAY_REPORT_FRAMES : 0;
+		for (size_t i = first; i < capture.records.size(); ++i) {
+			LogFrameRecord("recorded", capture.records[i]);
+			if (const FrameRecord* p = hitch.Find(capture.records[i].frame)) LogFrameRecord("replay", *p);
+		}
+		TraceLog(diverged ? LOG_WARNING : LOG_INFO, "REPLAY: %u frames replayed, budget %.2f ms, RNG %s (%zu of %zu frames differ)",
+			capture.header.inputCount, capture.header.budgetMs, diverged ? "DIVERGED" : "matches", diverged, compared);
+	}
 
-				player->Draw();
+	void ReportFrameTimes() {
+		const LatencyHistogram& ft = hitch.FrameTimes();
+		TraceLog(LOG_INFO, "FRAMES: %llu, p50 %.2f ms, p99 %.2f ms, max %.2f ms, %d over %.2f ms budget, %d captures",
+			(unsigned long long)ft.Count(), ft.PercentileMs(0.5), ft.PercentileMs(0.99), ft.MaxMs(),
+			hitch.Hitches(), hitch.BudgetMs(), hitch.Captures());
+		if (!hitch.WriteHistogram("frame_times.txt")) {
+			TraceLog(LOG_WARNING, "Could not write frame_times.txt");
+		}
+	}
 
-				if (paused) {
-					DrawRectangle(0, 0, Renderer::Instance().Width(), Renderer::Instance().Height(), Fade(BLACK, 0.5f));
-					DrawText("PAUSED", C_WIDTH / 2 - 50, C_HEIGHT / 2, 40, RAYWHITE);
+	struct ExitEntry {
+		EntityKind kind;
+		uint32_t handle;
+		uint32_t tick;
+	};
+
+	uint32_t SimTick() const {
+		return static_cast<uint32_t>(simTime * SIM_TICK_RATE);
+	}
+
+	// Expires the entity on the first tick at or after 'seconds' from now. Returns that tick, 0 if never.
+	uint32_t ScheduleExit(EntityKind kind, uint32_t handle, float seconds) {
+		if (!(seconds < C_MAX_EXIT_TIME)) return 0; // not moving out
+		uint32_t tick = static_cast<uint32_t>(ceil((simTime + seconds) * SIM_TICK_RATE));
+		exits.Schedule(tick, { kind, handle, tick });
+		return tick;
+	}
+
+	void AddAsteroid(std::unique_ptr<Asteroid> asteroid) {
+		asteroid->SetHandle(asteroidHandles.Acquire(static_cast<uint32_t>(asteroids.size())));
+		asteroid->SetExitTick(ScheduleExit(EntityKind::ASTEROID, asteroid->GetHandle(), asteroid->ExitTime(world.ActiveBounds())));
+		// Shots that are waiting out a predicted gap may meet the newcomer sooner
+		uint32_t tick = SimTick();
+		for (int w = 0; w < WEAPON_COUNT; ++w) {
+			float radius = WEAPONS[w].radius + asteroid->GetRadius() + PREDICT_MARGIN;
+			for (Shot& s : shots[w]) {
+				if (s.nextCheckTick <= tick) continue;
+				float soonest = Utils::ContactTimeBound(Vector2Subtract(asteroid->GetPosition(), s.position),
+					Vector2Subtract(asteroid->GetVelocity(), s.velocity), radius);
+				s.nextCheckTick = std::min(s.nextCheckTick, PredictCheckTick(tick, soonest));
+			}
+		}
+		asteroids.push_back(std::move(asteroid));
+	}
+
+	// Straight up at the weapon's speed
+	void FireShot(WeaponType w, Vector2 position) {
+		shots[static_cast<int>(w)].push_back({ position, { 0, -Weapon(w).Speed() }, 0 });
+	}
+
+	uint8_t& ShotDead(uint32_t id) {
+		return shotDead[id >> SHOT_INDEX_BITS][id & SHOT_INDEX_MASK];
+	}
+
+	void AddHeart(Heart heart) {
+		heart.SetHandle(heartHandles.Acquire(static_cast<uint32_t>(hearts.size())));
+		heart.SetExitTick(ScheduleExit(EntityKind::HEART, heart.GetHandle(), heart.ExitTime(world.ActiveBounds())));
+		hearts.push_back(heart);
+	}
+
+	// --- Scripts ---
+	enum ScriptScope : uint32_t { SCOPE_GAME, SCOPE_ASTEROIDS, SCOPE_FLASH };
+
+	Task AsteroidSpawner() {
+		for (;;) {
+			// Nightmare spawns twice as often; the interval is drawn once per wait
+			float scale = nightmareMode ? 0.5f : 1.0f;
+			co_await Seconds(Utils::RandomFloat(rules.spawnMin * scale, rules.spawnMax * scale));
+			while (AsteroidsInView() >= MAX_AST) co_await NextTick;
+			std::unique_ptr<Asteroid> a = MakeAsteroid(C_WIDTH, C_HEIGHT, currentShape, nightmareMode);
+			Rectangle view = ViewBounds();
+			a->MoveBy({ view.x, view.y });
+			AddAsteroid(std::move(a));
+		}
+	}
+
+	Task HeartSpawner() {
+		for (;;) {
+			co_await Seconds(Utils::RandomFloat(rules.heartMin, rules.heartMax));
+			Heart heart(C_WIDTH, C_HEIGHT);
+			Rectangle view = ViewBounds();
+			heart.MoveBy({ view.x, view.y });
+			AddHeart(heart);
+		}
+	}
+
+	// A swarm flies in from just outside a random edge of the view
+	Task SwarmSpawner() {
+		for (;;) {
+			co_await Seconds(Utils::RandomFloat(C_SWARM_MIN, C_SWARM_MAX));
+			Rectangle view = ViewBounds();
+			float m = C_SWARM_MARGIN;
+			Vector2 center;
+			switch (Utils::RandomInt(0, 3)) {
+			case 0: center = { Utils::RandomFloat(view.x, view.x + view.width), view.y - m }; break;
+			case 1: center = { view.x + view.width + m, Utils::RandomFloat(view.y, view.y + view.height) }; break;
+			case 2: center = { Utils::RandomFloat(view.x, view.x + view.width), view.y + view.height + m }; break;
+			default: center = { view.x - m, Utils::RandomFloat(view.y, view.y + view.height) }; break;
+			}
+			Vector2 heading = Vector2Scale(Vector2Normalize(Vector2Subtract(player->GetPosition(), center)), EnemyShip::FLOCK.maxSpeed * 0.5f);
+			size_t count = std::min<size_t>(C_SWARM_SIZE, C_MAX_ENEMIES - enemies.size());
+			for (size_t i = 0; i < count; ++i) {
+				float ang = Utils::RandomFloat(0, 2 * PI);
+				float rad = Utils::RandomFloat(0, C_SWARM_SPREAD);
+				Vector2 p = { center.x + cosf(ang) * rad, center.y + sinf(ang) * rad };
+				enemies.emplace_back(p, heading, enemyPhase++, nightmareMode);
+			}
+		}
+	}
+
+	// Full white screen fading out over C_FLASH_TIME
+	Task FlashScript() {
+		for (float left = C_FLASH_TIME; left > 0.0f; left -= scripts.Delta()) {
+			flashAmount = left / C_FLASH_TIME;
+			co_await NextTick;
+		}
+		flashAmount = 0.0f;
+	}
+
+	// Moves everything and detects collisions. Reads entities, writes only events and per-entity flags.
+	void Simulate(float dt) {
+		EventBuffer& main = events.Buffer(0);
+		int heartCount = static_cast<int>(hearts.size());
+		int asteroidCount = static_cast<int>(asteroids.size());
+
+		simTime += dt;
+		uint32_t tick = SimTick();
+
+		// Everything whose exit time has passed, O(1) per expired entity
+		heartGone.assign(heartCount, 0);
+		for (int w = 0; w < WEAPON_COUNT; ++w) shotGone[w].assign(shots[w].size(), 0);
+		asteroidGone.assign(asteroidCount, 0);
+		exits.Advance(tick, [&](const ExitEntry& e) {
+			HandleMap& handles = e.kind == EntityKind::ASTEROID ? asteroidHandles : heartHandles;
+			std::vector<uint8_t>& gone = e.kind == EntityKind::ASTEROID ? asteroidGone : heartGone;
+			uint32_t i = handles.Index(e.handle);
+			if (i == HandleMap::INVALID) return; // destroyed before it got out
+			uint32_t current = e.kind == EntityKind::ASTEROID ? asteroids[i]->GetExitTick() : hearts[i].GetExitTick();
+			if (current != e.tick) return; // window moved since
+			gone[i] = 1;
+			main.Push(GameEventType::ENTITY_EXPIRED, i, 0, 0, e.kind);
+		});
+
+		AdvanceHearts(hearts, dt, 0, heartCount);
+		DetectHeartPickups(*player, hearts, heartGone, rules.heartHeal, 0, heartCount, main);
+
+		// Asteroid-Ship collisions use positions from before the asteroids move
+		DetectPlayerHits(*player, asteroids, asteroidGone, 0, asteroidCount, main);
+
+		// Shots and asteroids are tested at the same time point so contact prediction holds
+		Rectangle bounds = world.ActiveBounds();
+		ForEachWeapon([&](auto w) {
+			constexpr int W = static_cast<int>(decltype(w)::value);
+			AdvanceShots<w>(shots[W], shotGone[W], bounds, dt, 0, static_cast<int>(shots[W].size()), main);
+		});
+		AdvanceAsteroids(asteroids, dt, 0, asteroidCount);
+
+		// Shot-Asteroid collisions O(n*m) for pairs that can be in contact, split across workers once it gets big
+		ForEachWeapon([&](auto w) {
+			constexpr int W = static_cast<int>(decltype(w)::value);
+			int count = static_cast<int>(shots[W].size());
+			if (static_cast<size_t>(count) * asteroidCount >= C_PARALLEL_PAIRS) {
+				JobPool::Instance().ParallelFor(count, C_MIN_PROJECTILE_CHUNK, [&](int begin, int end, int worker) {
+					DetectShotHits<w>(shots[W], shotGone[W], asteroids, asteroidGone, tick, begin, end, events.Buffer(worker));
+				});
+			}
+			else {
+				DetectShotHits<w>(shots[W], shotGone[W], asteroids, asteroidGone, tick, 0, count, main);
+			}
+		});
+
+		// Swarms: a quarter re-plans per tick, then the index is rebuilt for hits and the next plans
+		AdvanceEnemies(enemies, enemyIndex, player->GetPosition(), tick, dt, 0, static_cast<int>(enemies.size()));
+		IndexEnemies(enemies, enemyIndex);
+		DetectEnemyContacts(*player, enemyIndex, main);
+		ForEachWeapon([&](auto w) {
+			constexpr int W = static_cast<int>(decltype(w)::value);
+			DetectEnemyHits<w>(shots[W], shotGone[W], enemyIndex, 0, static_cast<int>(shots[W].size()), main);
+		});
+	}
+
+	// Live counters for external dashboards, read by MetricsReader
+	void PublishMetrics(float dt, bool nightmare, bool paused) {
+		if (!metrics.IsOpen()) return;
+		metrics.RecordFrame(dt);
+		metrics.RecordScore(score, dt);
+		metrics.RecordNightmare(nightmare);
+
+		MetricsSnapshot& m = metrics.Live();
+		const LatencyHistogram& lat = Renderer::Instance().Pacer().Latency();
+		m.latencyP50Ms = static_cast<float>(lat.PercentileMs(0.5));
+		m.latencyP99Ms = static_cast<float>(lat.PercentileMs(0.99));
+		m.asteroids = static_cast<uint32_t>(asteroids.size());
+		m.projectiles = static_cast<uint32_t>(ShotCount(shots));
+		m.hearts = static_cast<uint32_t>(hearts.size());
+		m.enemies = static_cast<uint32_t>(enemies.size());
+		m.drawCalls = static_cast<uint32_t>(Renderer::Instance().LastFrame().drawCalls);
+		m.hp = player->GetHP();
+		m.paused = paused;
+		for (int i = 0; i < EventQueue::TYPES; ++i) {
+			m.events[i] = events.TotalCount(static_cast<GameEventType>(i));
+		}
+		metrics.Publish();
+	}
+
+	// The only place where gameplay state changes as a result of collisions
+	void ResolveEvents() {
+		asteroidDead.assign(asteroids.size(), 0);
+		asteroidAsleep.assign(asteroids.size(), 0);
+		for (int w = 0; w < WEAPON_COUNT; ++w) shotDead[w].assign(shots[w].size(), 0);
+		heartDead.assign(hearts.size(), 0);
+		enemyDead.assign(enemies.size(), 0);
+
+		events.Resolve([this](const GameEvent& e) {
+			switch (e.type) {
+			case GameEventType::BOOST_FIRED:
+				// Power Boost: usuń wszystkie asteroidy
+				scripts.Cancel(SCOPE_FLASH);
+				scripts.Start(FlashScript(), SCOPE_FLASH);
+				std::fill(asteroidDead.begin(), asteroidDead.end(), 1);
+				std::fill(enemyDead.begin(), enemyDead.end(), 1);
+				powerBoostAvailable = false;
+				boostCharge = 0.0f;
+				break;
+			case GameEventType::ASTEROID_DESTROYED:
+				if (ShotDead(e.a) || asteroidDead[e.b]) break;
+				ShotDead(e.a) = 1;
+				asteroidDead[e.b] = 1;
+				AddScore(e.value);
+				break;
+			case GameEventType::ENEMY_DESTROYED:
+				if (ShotDead(e.a) || enemyDead[e.b]) break;
+				ShotDead(e.a) = 1;
+				enemyDead[e.b] = 1;
+				AddScore(e.value);
+				break;
+			case GameEventType::HEART_COLLECTED:
+				if (heartDead[e.a]) break;
+				if (player->IsAlive() && player->GetHP() < Ship::MAX_HP) {
+					int missing = Ship::MAX_HP - player->GetHP();
+					player->TakeDamage(-std::min(e.value, missing)); // lecz tylko brakujące
 				}
-				Renderer::Instance().End();
+				heartDead[e.a] = 1;
+				break;
+			case GameEventType::PLAYER_HIT: {
+				std::vector<uint8_t>& dead = e.kind == EntityKind::ENEMY ? enemyDead : asteroidDead;
+				if (dead[e.a] || !player->IsAlive()) break;
+				player->TakeDamage(e.value);
+				dead[e.a] = 1;
+				break;
+			}
+			case GameEventType::ENTITY_EXPIRED:
+				if (e.kind == EntityKind::ASTEROID) {
+					// Left the awake sectors: back to sleep, not destroyed
+					if (!asteroidDead[e.a]) asteroidAsleep[e.a] = 1;
+					asteroidDead[e.a] = 1;
+				}
+				else if (e.kind == EntityKind::PROJECTILE) ShotDead(e.a) = 1;
+				else if (e.kind == EntityKind::HEART) heartDead[e.a] = 1;
+				break;
+			default:
+				break;
 			}
+		});
+
+		Vector2 size = world.WorldSize();
+		CompactByFlags(asteroids, asteroidDead, asteroidHandles, [](const auto& a) { return a->GetHandle(); },
+			[&](std::unique_ptr<Asteroid>& a, size_t i) {
+				if (!asteroidAsleep[i]) return;
+				a->Drift(0.f, size);
+				world.Sleep(std::move(a), simTime, woken);
+			});
+		for (int w = 0; w < WEAPON_COUNT; ++w) CompactByFlags(shots[w], shotDead[w]);
+		CompactByFlags(hearts, heartDead, heartHandles, [](const Heart& h) { return h.GetHandle(); });
+		CompactByFlags(enemies, enemyDead);
+		WakeAsteroids(); // stale exits inside the window
+	}
+
+	void AddScore(int value) {
+		score += value;
+		boostCharge += value / 300.0f;
+		if (boostCharge >= 1.0f) {
+			boostCharge = 1.0f;
+			powerBoostAvailable = true;
 		}
-		Heart::UnloadAssets();
-		Projectile::UnloadAssets();
 	}
 
-private:
 	Application()
 	{
 		asteroids.reserve(1000);
-		projectiles.reserve(10'000);
+		for (auto& s : shots) s.reserve(C_MAX_PROJECTILES);
+		enemies.reserve(C_MAX_ENEMIES);
+		world.Init(C_WORLD_SECTORS, C_WORLD_SECTORS, C_SECTOR_SIZE);
+		camera.offset = { C_WIDTH * 0.5f, C_HEIGHT * 0.5f };
+		camera.zoom = 1.f;
 	};
 
+	std::unique_ptr<PlayerShip> player;
 	std::vector<std::unique_ptr<Asteroid>> asteroids;
-	std::vector<Projectile> projectiles;
+	ShotArrays shots;
+	std::vector<EnemyShip> enemies;
+	FlockIndex enemyIndex;
+	uint32_t enemyPhase = 0;
+
+	EventQueue events;
+	std::vector<uint8_t> heartGone;
+	std::array<std::vector<uint8_t>, WEAPON_COUNT> shotGone;
+	std::vector<uint8_t> asteroidGone;
+	std::vector<uint8_t> asteroidDead;
+	std::array<std::vector<uint8_t>, WEAPON_COUNT> shotDead;
+	std::vector<uint8_t> heartDead;
+	std::vector<uint8_t> enemyDead;
+
+	double simTime = 0.0;
+	TimingWheel<ExitEntry> exits;
+	HandleMap asteroidHandles;
+	HandleMap heartHandles;
+	MetricsExporter metrics;
+	HitchDetector hitch;
+
+	SectorGrid<std::unique_ptr<Asteroid>> world;
+	std::vector<std::unique_ptr<Asteroid>> woken;
+	std::vector<uint8_t> asteroidAsleep;
+	Camera2D camera{};
+	int worldAsteroids = 0;
 
 	AsteroidShape currentShape = AsteroidShape::TRIANGLE;
+	WeaponType currentWeapon = WeaponType::LASER;
+	float shotTimer = 0.f;
+	bool paused = false;
 
 	static constexpr int C_WIDTH = 1200;
 	static constexpr int C_HEIGHT = 1200;
-	static constexpr size_t MAX_AST = 150;
-	static constexpr float C_SPAWN_MIN = 0.5f;
-	static constexpr float C_SPAWN_MAX = 3.0f;
+	static constexpr size_t MAX_AST = 150; // spawned into the view, not counting the world population
 
 	static constexpr int C_MAX_ASTEROIDS = 1000;
 	static constexpr int C_MAX_PROJECTILES = 10'000;
+	static constexpr float C_FLASH_TIME = 0.2f;
+	static constexpr size_t C_PARALLEL_PAIRS = 64 * 1024;
+	static constexpr int C_MIN_PROJECTILE_CHUNK = 256;
+	static constexpr float C_MAX_EXIT_TIME = 3600.f;
+	static constexpr size_t C_REPLAY_REPORT_FRAMES = 20;
+	static constexpr int C_WORLD_SECTORS = 16;     // per side, one window-sized sector each
+	static constexpr float C_SECTOR_SIZE = 1200.f;
+	static constexpr int C_ACTIVE_RADIUS = 1;      // 3x3 sectors around the camera are awake
+	static constexpr float C_SLEEP_REFRESH = 1.f;  // < (sector - half view) / fastest asteroid
+	static constexpr size_t C_MAX_ENEMIES = 5000;
+	static constexpr size_t C_SWARM_SIZE = 24;
+	static constexpr float C_SWARM_MIN = 8.f;
+	static constexpr float C_SWARM_MAX = 14.f;
+	static constexpr float C_SWARM_MARGIN = 150.f;  // outside the view
+	static constexpr float C_SWARM_SPREAD = 80.f;
+	GameRules rules;
 	int score = 0;
 	bool powerBoostAvailable = false;
-	bool flashActive = false;
-	float flashTimer = 0.0f;
+	bool nightmareMode = false;
+	float flashAmount = 0.0f;
 	float boostCharge = 0.0f;
 
 	std::vector<Heart> hearts;
-	float heartSpawnTimer = 0.0f;
-	float heartSpawnInterval = Utils::RandomFloat(12.0f, 15.0f);
+	ScriptScheduler scripts;
+
+	bool showLatency = false;
+	bool sdfOutlines = true;
 
 };
 
-int main() {
-	Application::Instance().Run();
+#ifndef UNICORNS_NO_MAIN
+// Main [--replay capture.bin] [--hitch-budget ms] [--no-hitch-capture] [--record] [--capture-scale n]
+//      [--world-asteroids n]
+int main(int argc, char** argv) {
+	RunOptions options;
+	for (int i = 1; i < argc; ++i) {
+		if (TextIsEqual(argv[i], "--replay") && i + 1 < argc) options.replayPath = argv[++i];
+		else if (TextIsEqual(argv[i], "--hitch-budget") && i + 1 < argc) options.hitchBudgetMs = strtof(argv[++i], nullptr);
+		else if (TextIsEqual(argv[i], "--no-hitch-capture")) options.hitchCapture = false;
+		else if (TextIsEqual(argv[i], "--record")) options.record = true;
+		else if (TextIsEqual(argv[i], "--capture-scale") && i + 1 < argc) options.captureScale = atoi(argv[++i]);
+		else if (TextIsEqual(argv[i], "--world-asteroids") && i + 1 < argc) options.worldAsteroids = std::max(atoi(argv[++i]), 0);
+	}
+	Application::Instance().Run(options);
 	return 0;
 }
+#endif
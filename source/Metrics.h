@@ -0,0 +1,263 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "GameEvents.h"
+
+#if defined(_WIN32)
+// windows.h clashes with raylib (CloseWindow, DrawText, Rectangle...), declare only what we need
+extern "C" {
+	__declspec(dllimport) void* __stdcall CreateFileMappingA(void* file, void* attributes, unsigned long protect,
+		unsigned long sizeHigh, unsigned long sizeLow, const char* name);
+	__declspec(dllimport) void* __stdcall OpenFileMappingA(unsigned long access, int inherit, const char* name);
+	__declspec(dllimport) void* __stdcall MapViewOfFile(void* mapping, unsigned long access, unsigned long offsetHigh,
+		unsigned long offsetLow, size_t bytes);
+	__declspec(dllimport) int __stdcall UnmapViewOfFile(const void* base);
+	__declspec(dllimport) int __stdcall CloseHandle(void* handle);
+}
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// --- LIVE METRICS ---
+// Counters and a frame time histogram in a named shared-memory segment, rewritten every
+// frame. One writer (the game) and any number of readers (MetricsReader). The writer
+// never waits: a sequence counter is odd while a write is in progress and readers retry
+// until they copy a snapshot with the same even value before and after.
+
+static constexpr const char* METRICS_SEGMENT_NAME = "unicorns_metrics";
+static constexpr uint32_t METRICS_MAGIC = 0x554E4943; // "UNIC"
+static constexpr uint32_t METRICS_VERSION = 3;
+
+// Upper bounds in ms, the last bucket catches everything above
+static constexpr float METRICS_FRAME_BUCKETS_MS[] = { 4.f, 8.f, 12.f, 16.7f, 20.f, 25.f, 33.3f, 50.f, 100.f };
+static constexpr int METRICS_FRAME_BUCKETS = sizeof(METRICS_FRAME_BUCKETS_MS) / sizeof(float) + 1;
+
+// Plain data, copied in and out as a whole under the sequence counter
+struct MetricsSnapshot {
+	uint64_t frame;
+	double   uptimeSeconds;
+	float    frameMs;
+	float    latencyP50Ms;
+	float    latencyP99Ms;
+	uint32_t asteroids;
+	uint32_t projectiles;
+	uint32_t hearts;
+	uint32_t enemies;
+	uint32_t drawCalls;      // GL draw calls of the last frame
+	int32_t  score;
+	float    scorePerSecond; // smoothed over roughly SCORE_RATE_WINDOW seconds
+	int32_t  hp;
+	uint32_t nightmare;
+	uint32_t paused;
+	uint64_t nightmareTransitions;
+	uint64_t frameCount;
+	double   frameTimeSumMs;
+	uint64_t frameBuckets[METRICS_FRAME_BUCKETS]; // per bucket, not cumulative
+	uint64_t events[EventQueue::TYPES];
+};
+
+struct MetricsSegment {
+	uint32_t magic;
+	uint32_t version;
+	std::atomic<uint32_t> sequence;
+	uint32_t snapshotSize;
+	int64_t writerPid; // a killed writer can't unlink the segment, readers check the process
+	MetricsSnapshot data;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "sequence counter must be address-free");
+
+// Maps the named segment, creating it for the writer. Returns nullptr on failure.
+class MetricsMapping {
+public:
+	~MetricsMapping() {
+		Close();
+	}
+
+	MetricsSegment* Open(const char* name, bool create) {
+		Close();
+		owner = create;
+#if defined(_WIN32)
+		char path[128] = "Local\\";
+		CopyName(path + 6, name, sizeof(path) - 6);
+		const unsigned long PAGE_READWRITE_ = 0x04;
+		const unsigned long FILE_MAP_READ_ = 0x04;
+		const unsigned long FILE_MAP_WRITE_ = 0x02;
+		handle = create
+			? CreateFileMappingA(reinterpret_cast<void*>(static_cast<intptr_t>(-1)), nullptr, PAGE_READWRITE_, 0, sizeof(MetricsSegment), path)
+			: OpenFileMappingA(FILE_MAP_READ_, 0, path);
+		if (!handle) return nullptr;
+		void* base = MapViewOfFile(handle, create ? FILE_MAP_WRITE_ : FILE_MAP_READ_, 0, 0, sizeof(MetricsSegment));
+		if (!base) {
+			Close();
+			return nullptr;
+		}
+#else
+		path[0] = '/';
+		CopyName(path + 1, name, sizeof(path) - 1);
+		int fd = create ? shm_open(path, O_RDWR | O_CREAT, 0644) : shm_open(path, O_RDONLY, 0);
+		if (fd < 0) return nullptr;
+		if (create && ftruncate(fd, sizeof(MetricsSegment)) != 0) {
+			close(fd);
+			return nullptr;
+		}
+		void* base = mmap(nullptr, sizeof(MetricsSegment), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (base == MAP_FAILED) return nullptr;
+#endif
+		segment = static_cast<MetricsSegment*>(base);
+		return segment;
+	}
+
+	void Close() {
+		if (!segment) return;
+#if defined(_WIN32)
+		UnmapViewOfFile(segment);
+		CloseHandle(handle);
+		handle = nullptr;
+#else
+		munmap(segment, sizeof(MetricsSegment));
+		if (owner) shm_unlink(path); // readers see the game is gone
+#endif
+		segment = nullptr;
+	}
+
+private:
+	static void CopyName(char* dst, const char* src, size_t cap) {
+		size_t n = strlen(src) < cap - 1 ? strlen(src) : cap - 1;
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+
+	MetricsSegment* segment = nullptr;
+	bool owner = false;
+#if defined(_WIN32)
+	void* handle = nullptr;
+#else
+	char path[128] = {};
+#endif
+};
+
+// Game side. Accumulates into a local snapshot and publishes it once per frame.
+class MetricsExporter {
+public:
+	bool Open(const char* name = METRICS_SEGMENT_NAME) {
+		segment = mapping.Open(name, true);
+		if (!segment) return false;
+		segment->sequence.store(0, std::memory_order_relaxed);
+		segment->snapshotSize = sizeof(MetricsSnapshot);
+		segment->version = METRICS_VERSION;
+#if !defined(_WIN32)
+		segment->writerPid = getpid();
+#endif
+		memset(&segment->data, 0, sizeof(MetricsSnapshot));
+		std::atomic_thread_fence(std::memory_order_release);
+		segment->magic = METRICS_MAGIC; // last, readers check it first
+		return true;
+	}
+
+	void Close() {
+		if (segment) segment->magic = 0;
+		mapping.Close();
+		segment = nullptr;
+	}
+
+	bool IsOpen() const {
+		return segment != nullptr;
+	}
+
+	MetricsSnapshot& Live() {
+		return live;
+	}
+
+	void RecordFrame(float dt) {
+		float ms = dt * 1000.f;
+		int bucket = 0;
+		while (bucket < METRICS_FRAME_BUCKETS - 1 && ms > METRICS_FRAME_BUCKETS_MS[bucket]) bucket++;
+		live.frame++;
+		live.frameMs = ms;
+		live.frameCount++;
+		live.frameTimeSumMs += ms;
+		live.frameBuckets[bucket]++;
+		live.uptimeSeconds += dt;
+	}
+
+	void RecordScore(int score, float dt) {
+		if (dt > 0.f) {
+			// Restart drops the score, that's not negative scoring
+			float rate = score >= live.score ? (score - live.score) / dt : 0.f;
+			float k = 1.f - expf(-dt / SCORE_RATE_WINDOW);
+			live.scorePerSecond += (rate - live.scorePerSecond) * k;
+		}
+		live.score = score;
+	}
+
+	void RecordNightmare(bool on) {
+		if (static_cast<uint32_t>(on) != live.nightmare) live.nightmareTransitions++;
+		live.nightmare = on;
+	}
+
+	// Copies the live snapshot into the segment; never blocks
+	void Publish() {
+		if (!segment) return;
+		uint32_t seq = segment->sequence.load(std::memory_order_relaxed);
+		segment->sequence.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		memcpy(&segment->data, &live, sizeof(MetricsSnapshot));
+		segment->sequence.store(seq + 2, std::memory_order_release);
+	}
+
+private:
+	static constexpr float SCORE_RATE_WINDOW = 5.f;
+
+	MetricsMapping mapping;
+	MetricsSegment* segment = nullptr;
+	MetricsSnapshot live{};
+};
+
+// Reader side. Read() returns false while the game is not running or mid-restart.
+class MetricsSubscriber {
+public:
+	bool Open(const char* name = METRICS_SEGMENT_NAME) {
+		segment = mapping.Open(name, false);
+		return segment != nullptr;
+	}
+
+	void Close() {
+		mapping.Close();
+		segment = nullptr;
+	}
+
+	bool Read(MetricsSnapshot& out) const {
+		if (!segment || segment->magic != METRICS_MAGIC || segment->version != METRICS_VERSION ||
+			segment->snapshotSize != sizeof(MetricsSnapshot)) {
+			return false;
+		}
+#if !defined(_WIN32)
+		if (kill(static_cast<pid_t>(segment->writerPid), 0) != 0 && errno != EPERM) return false;
+#endif
+		for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+			uint32_t before = segment->sequence.load(std::memory_order_acquire);
+			if (before & 1) continue; // write in progress
+			memcpy(&out, &segment->data, sizeof(MetricsSnapshot));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (segment->sequence.load(std::memory_order_relaxed) == before) return true;
+		}
+		return false;
+	}
+
+private:
+	static constexpr int MAX_ATTEMPTS = 1000;
+
+	MetricsMapping mapping;
+	MetricsSegment* segment = nullptr;
+};
@@ -0,0 +1,148 @@
+// Reads the live metrics the game publishes to shared memory (see Metrics.h).
+// Standalone, no raylib.
+//
+//   MetricsReader                         one status line per interval
+//   MetricsReader --prometheus            Prometheus text format once, to stdout
+//   MetricsReader --prometheus-file path  rewrites 'path' every interval (node_exporter textfile collector)
+//
+// Options: --name segment, --interval ms (default 1000).
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "Metrics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace Reader {
+	static constexpr int DEFAULT_INTERVAL_MS = 1000;
+
+	// Tries to (re)attach when there is no consistent snapshot, e.g. after the game restarted
+	static bool Poll(MetricsSubscriber& sub, const char* name, MetricsSnapshot& out) {
+		if (sub.Read(out)) return true;
+		sub.Close();
+		return sub.Open(name) && sub.Read(out);
+	}
+
+	static void WriteStatus(FILE* f, bool up, const MetricsSnapshot& m) {
+		if (!up) {
+			fprintf(f, "game not running\n");
+			return;
+		}
+		fprintf(f, "frame %llu  %.2f ms  ast %u  proj %u  hearts %u  enemies %u  draws %u  score %d (%.1f/s)  hp %d  %s%s  lat p50 %.2f p99 %.2f ms\n",
+			(unsigned long long)m.frame, m.frameMs, m.asteroids, m.projectiles, m.hearts, m.enemies, m.drawCalls, m.score, m.scorePerSecond, m.hp,
+			m.nightmare ? "NIGHTMARE" : "normal", m.paused ? " paused" : "", m.latencyP50Ms, m.latencyP99Ms);
+	}
+
+	static void WritePrometheus(FILE* f, bool up, const MetricsSnapshot& m) {
+		fprintf(f, "# HELP unicorns_up Whether the game is publishing metrics.\n# TYPE unicorns_up gauge\n");
+		fprintf(f, "unicorns_up %d\n", up ? 1 : 0);
+		if (!up) return;
+
+		fprintf(f, "# HELP unicorns_uptime_seconds Sum of frame times since the game started.\n# TYPE unicorns_uptime_seconds gauge\n");
+		fprintf(f, "unicorns_uptime_seconds %.3f\n", m.uptimeSeconds);
+
+		fprintf(f, "# HELP unicorns_frame_seconds Frame time.\n# TYPE unicorns_frame_seconds histogram\n");
+		uint64_t cumulative = 0;
+		for (int i = 0; i < METRICS_FRAME_BUCKETS - 1; ++i) {
+			cumulative += m.frameBuckets[i];
+			fprintf(f, "unicorns_frame_seconds_bucket{le=\"%g\"} %llu\n", METRICS_FRAME_BUCKETS_MS[i] / 1000.0, (unsigned long long)cumulative);
+		}
+		cumulative += m.frameBuckets[METRICS_FRAME_BUCKETS - 1];
+		fprintf(f, "unicorns_frame_seconds_bucket{le=\"+Inf\"} %llu\n", (unsigned long long)cumulative);
+		fprintf(f, "unicorns_frame_seconds_sum %.6f\n", m.frameTimeSumMs / 1000.0);
+		fprintf(f, "unicorns_frame_seconds_count %llu\n", (unsigned long long)m.frameCount);
+
+		fprintf(f, "# HELP unicorns_last_frame_seconds Duration of the last frame.\n# TYPE unicorns_last_frame_seconds gauge\n");
+		fprintf(f, "unicorns_last_frame_seconds %.6f\n", m.frameMs / 1000.0);
+
+		fprintf(f, "# HELP unicorns_input_latency_seconds Input poll to present latency.\n# TYPE unicorns_input_latency_seconds gauge\n");
+		fprintf(f, "unicorns_input_latency_seconds{quantile=\"0.5\"} %.6f\n", m.latencyP50Ms / 1000.0);
+		fprintf(f, "unicorns_input_latency_seconds{quantile=\"0.99\"} %.6f\n", m.latencyP99Ms / 1000.0);
+
+		fprintf(f, "# HELP unicorns_entities Live entities by kind.\n# TYPE unicorns_entities gauge\n");
+		fprintf(f, "unicorns_entities{kind=\"asteroid\"} %u\n", m.asteroids);
+		fprintf(f, "unicorns_entities{kind=\"projectile\"} %u\n", m.projectiles);
+		fprintf(f, "unicorns_entities{kind=\"heart\"} %u\n", m.hearts);
+		fprintf(f, "unicorns_entities{kind=\"enemy\"} %u\n", m.enemies);
+
+		fprintf(f, "# HELP unicorns_draw_calls GL draw calls in the last frame.\n# TYPE unicorns_draw_calls gauge\n");
+		fprintf(f, "unicorns_draw_calls %u\n", m.drawCalls);
+
+		fprintf(f, "# HELP unicorns_score Current score.\n# TYPE unicorns_score gauge\n");
+		fprintf(f, "unicorns_score %d\n", m.score);
+		fprintf(f, "# HELP unicorns_score_per_second Score rate, smoothed over a few seconds.\n# TYPE unicorns_score_per_second gauge\n");
+		fprintf(f, "unicorns_score_per_second %.3f\n", m.scorePerSecond);
+		fprintf(f, "# HELP unicorns_hp Player hit points.\n# TYPE unicorns_hp gauge\n");
+		fprintf(f, "unicorns_hp %d\n", m.hp);
+		fprintf(f, "# HELP unicorns_nightmare Whether nightmare mode is on.\n# TYPE unicorns_nightmare gauge\n");
+		fprintf(f, "unicorns_nightmare %u\n", m.nightmare);
+		fprintf(f, "# HELP unicorns_paused Whether the game is paused.\n# TYPE unicorns_paused gauge\n");
+		fprintf(f, "unicorns_paused %u\n", m.paused);
+		fprintf(f, "# HELP unicorns_nightmare_transitions_total Nightmare mode switches, both ways.\n# TYPE unicorns_nightmare_transitions_total counter\n");
+		fprintf(f, "unicorns_nightmare_transitions_total %llu\n", (unsigned long long)m.nightmareTransitions);
+
+		fprintf(f, "# HELP unicorns_events_total Gameplay events by type.\n# TYPE unicorns_events_total counter\n");
+		for (int i = 0; i < EventQueue::TYPES; ++i) {
+			fprintf(f, "unicorns_events_total{type=\"%s\"} %llu\n", GameEventName(static_cast<GameEventType>(i)),
+				(unsigned long long)m.events[i]);
+		}
+	}
+
+	// Writes next to the target and renames, so a scraper never sees half a file
+	static bool WritePrometheusFile(const std::string& path, bool up, const MetricsSnapshot& m) {
+		std::string tmp = path + ".tmp";
+		FILE* f = fopen(tmp.c_str(), "w");
+		if (!f) return false;
+		WritePrometheus(f, up, m);
+		fclose(f);
+#if defined(_WIN32)
+		remove(path.c_str());
+#endif
+		return rename(tmp.c_str(), path.c_str()) == 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	const char* name = METRICS_SEGMENT_NAME;
+	const char* promFile = nullptr;
+	bool prometheus = false;
+	int intervalMs = Reader::DEFAULT_INTERVAL_MS;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--name") && i + 1 < argc) name = argv[++i];
+		else if (!strcmp(argv[i], "--interval") && i + 1 < argc) intervalMs = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--prometheus")) prometheus = true;
+		else if (!strcmp(argv[i], "--prometheus-file") && i + 1 < argc) promFile = argv[++i];
+		else {
+			printf("usage: %s [--name segment] [--interval ms] [--prometheus | --prometheus-file path]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (intervalMs < 10) intervalMs = 10;
+
+	MetricsSubscriber sub;
+	MetricsSnapshot m{};
+	if (prometheus) {
+		bool up = Reader::Poll(sub, name, m);
+		Reader::WritePrometheus(stdout, up, m);
+		return up ? 0 : 1;
+	}
+
+	for (;;) {
+		bool up = Reader::Poll(sub, name, m);
+		if (promFile) {
+			if (!Reader::WritePrometheusFile(promFile, up, m)) {
+				fprintf(stderr, "could not write %s\n", promFile);
+				return 2;
+			}
+		}
+		else {
+			Reader::WriteStatus(stdout, up, m);
+			fflush(stdout);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+	}
+}
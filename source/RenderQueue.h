@@ -0,0 +1,342 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <raylib.h>
+#include <rlgl.h>
+#include "external/glad.h"
+
+#include "SoftRaster.h"
+
+// --- RENDER QUEUE ---
+// Draws are recorded as commands with a 64-bit sort key and replayed by Flush() in key
+// order. rlgl starts a new batch draw whenever the texture or primitive type changes,
+// so sorting by those puts all lines, all shape quads and all quads of one texture
+// into one draw each, instead of one per switch in the order the game draws things.
+//
+//   key: layer 8 | shader 8 | texture 16 | primitive 8 | depth 16 | unused 8
+//
+// Order only holds between layers (and depths inside a layer); anything else can be
+// reordered, so what must stay on top goes to a later layer. The sort is stable, so
+// commands with equal keys keep the order they were submitted in.
+
+enum class RenderLayer : uint8_t { BACKGROUND, WORLD, PLAYER, HUD };
+
+class RenderQueue {
+public:
+	void SetLayer(RenderLayer l) { layer = l; }
+	void SetDepth(uint16_t d) { depth = d; }
+
+	// Until the next SetShader(); id 0 is the default shader
+	void SetShader(Shader s) {
+		if (s.id == rlGetShaderIdDefault()) {
+			shader = 0;
+			return;
+		}
+		for (size_t i = 1; i < shaders.size(); ++i) {
+			if (shaders[i].id == s.id) {
+				shader = static_cast<uint8_t>(i);
+				return;
+			}
+		}
+		shader = static_cast<uint8_t>(shaders.size());
+		shaders.push_back(s);
+	}
+
+	// Replays in submission order when off, for comparing draw call counts
+	void SetSorting(bool on) { sorting = on; }
+	bool Sorting() const { return sorting; }
+
+	// Replays into a CPU rasterizer instead of raylib while set; shaders are ignored
+	void SetSoftware(SoftRaster* raster) { soft = raster; }
+	SoftRaster* Software() const { return soft; }
+
+	void Line(Vector2 a, Vector2 b, Color c) {
+		Command& cmd = Push(Type::LINE, RL_LINES, ShapesTexture(), c);
+		cmd.v[0] = a;
+		cmd.v[1] = b;
+	}
+
+	// Closed polyline through p[0..count)
+	void Outline(const Vector2* p, int count, Color c) {
+		if (count < 2) return;
+		Command& cmd = Push(Type::OUTLINE, RL_LINES, ShapesTexture(), c);
+		cmd.first = static_cast<uint32_t>(points.size());
+		cmd.count = static_cast<uint32_t>(count);
+		points.insert(points.end(), p, p + count);
+	}
+
+	void PolyLines(Vector2 center, int sides, float radius, float rotation, Color c) {
+		Command& cmd = Push(Type::POLY_LINES, RL_LINES, ShapesTexture(), c);
+		cmd.v[0] = center;
+		cmd.v[1] = { radius, rotation };
+		cmd.count = static_cast<uint32_t>(sides);
+	}
+
+	void Triangle(Vector2 a, Vector2 b, Vector2 c, Color color) {
+		Command& cmd = Push(Type::TRIANGLE, RL_QUADS, ShapesTexture(), color);
+		cmd.v[0] = a;
+		cmd.v[1] = b;
+		cmd.v[2] = c;
+	}
+
+	void Rect(Rectangle r, Color c) {
+		Command& cmd = Push(Type::RECT, RL_QUADS, ShapesTexture(), c);
+		cmd.v[0] = { r.x, r.y };
+		cmd.v[1] = { r.width, r.height };
+	}
+
+	void RectLines(Rectangle r, float thick, Color c) {
+		Command& cmd = Push(Type::RECT_LINES, RL_QUADS, ShapesTexture(), c);
+		cmd.v[0] = { r.x, r.y };
+		cmd.v[1] = { r.width, r.height };
+		cmd.v[2] = { thick, 0.f };
+	}
+
+	// DrawTextureEx()
+	void Texture(Texture2D t, Vector2 position, float rotation, float scale, Color tint) {
+		Command& cmd = Push(Type::TEXTURE, RL_QUADS, t.id, tint);
+		cmd.texture = t;
+		cmd.v[0] = position;
+		cmd.v[1] = { rotation, scale };
+	}
+
+	// DrawText(); the string is copied
+	void Text(const char* text, int x, int y, int fontSize, Color c) {
+		Command& cmd = Push(Type::TEXT, RL_QUADS, GetFontDefault().texture.id, c);
+		cmd.first = static_cast<uint32_t>(chars.size());
+		cmd.v[0] = { static_cast<float>(x), static_cast<float>(y) };
+		cmd.count = static_cast<uint32_t>(fontSize);
+		chars.insert(chars.end(), text, text + strlen(text) + 1);
+	}
+
+	// Draws and clears everything submitted since the last flush
+	void Flush() {
+		if (commands.empty()) return;
+		if (sorting) Sort();
+		else {
+			order.resize(commands.size());
+			for (size_t i = 0; i < order.size(); ++i) order[i] = { keys[i], static_cast<uint32_t>(i) };
+		}
+
+		uint8_t active = 0;
+		uint64_t last = ~0ull;
+		for (const Entry& e : order) {
+			const Command& cmd = commands[e.index];
+			uint8_t s = soft ? 0 : static_cast<uint8_t>(e.key >> 48);
+			if (s != active) {
+				if (active) EndShaderMode();
+				if (s) BeginShaderMode(shaders[s]);
+				active = s;
+			}
+			uint64_t state = e.key & STATE_MASK;
+			if (state != last) stateChanges++;
+			last = state;
+			if (soft) ExecuteSoftware(cmd, *soft);
+			else Execute(cmd);
+		}
+		if (active) EndShaderMode();
+
+		flushed += commands.size();
+		commands.clear();
+		keys.clear();
+		points.clear();
+		chars.clear();
+	}
+
+	// Totals since the last TakeStats(), the owner takes them once per frame
+	struct Stats {
+		size_t commands = 0;
+		size_t stateChanges = 0; // shader / texture / primitive switches while flushing
+	};
+
+	Stats TakeStats() {
+		Stats s{ flushed, stateChanges };
+		flushed = 0;
+		stateChanges = 0;
+		return s;
+	}
+
+private:
+	enum class Type : uint8_t { LINE, OUTLINE, POLY_LINES, TRIANGLE, RECT, RECT_LINES, TEXTURE, TEXT };
+
+	struct Command {
+		Type type;
+		Color color;
+		uint32_t first;  // OUTLINE: into points, TEXT: into chars
+		uint32_t count;  // OUTLINE: points, POLY_LINES: sides, TEXT: font size
+		Vector2 v[3];
+		Texture2D texture;
+	};
+
+	struct Entry {
+		uint64_t key;
+		uint32_t index;
+	};
+
+	static constexpr uint64_t STATE_MASK = 0xFFFFFFFF00000000ull; // layer, shader, texture, primitive
+
+	// Shapes and lines draw with rlgl's white texture (the game never calls SetShapesTexture)
+	static unsigned int ShapesTexture() {
+		return rlGetTextureIdDefault();
+	}
+
+	Command& Push(Type type, int primitive, unsigned int texture, Color c) {
+		uint64_t key = static_cast<uint64_t>(layer) << 56 | static_cast<uint64_t>(shader) << 48 |
+			static_cast<uint64_t>(texture & 0xFFFF) << 32 | static_cast<uint64_t>(primitive & 0xFF) << 24 |
+			static_cast<uint64_t>(depth) << 8;
+		keys.push_back(key);
+		Command& cmd = commands.emplace_back();
+		cmd.type = type;
+		cmd.color = c;
+		return cmd;
+	}
+
+	// LSD radix sort on bytes, skipping the bytes every key has in common (usually most)
+	void Sort() {
+		size_t n = commands.size();
+		order.resize(n);
+		scratch.resize(n);
+		uint64_t same = ~0ull;
+		for (size_t i = 0; i < n; ++i) {
+			order[i] = { keys[i], static_cast<uint32_t>(i) };
+			same &= ~(keys[i] ^ keys[0]);
+		}
+		for (int shift = 8; shift < 64; shift += 8) {
+			if (((same >> shift) & 0xFF) == 0xFF) continue;
+			size_t offset[257] = {};
+			for (const Entry& e : order) offset[((e.key >> shift) & 0xFF) + 1]++;
+			for (int b = 0; b < 256; ++b) offset[b + 1] += offset[b];
+			for (const Entry& e : order) scratch[offset[(e.key >> shift) & 0xFF]++] = e;
+			order.swap(scratch);
+		}
+	}
+
+	void Execute(const Command& c) const {
+		switch (c.type) {
+		case Type::LINE:
+			DrawLineV(c.v[0], c.v[1], c.color);
+			break;
+		case Type::OUTLINE:
+			for (uint32_t i = 0; i < c.count; ++i) {
+				DrawLineV(points[c.first + i], points[c.first + (i + 1) % c.count], c.color);
+			}
+			break;
+		case Type::POLY_LINES:
+			DrawPolyLines(c.v[0], static_cast<int>(c.count), c.v[1].x, c.v[1].y, c.color);
+			break;
+		case Type::TRIANGLE:
+			DrawTriangle(c.v[0], c.v[1], c.v[2], c.color);
+			break;
+		case Type::RECT:
+			DrawRectangleV(c.v[0], c.v[1], c.color);
+			break;
+		case Type::RECT_LINES:
+			DrawRectangleLinesEx({ c.v[0].x, c.v[0].y, c.v[1].x, c.v[1].y }, c.v[2].x, c.color);
+			break;
+		case Type::TEXTURE:
+			DrawTextureEx(c.texture, c.v[0], c.v[1].x, c.v[1].y, c.color);
+			break;
+		case Type::TEXT:
+			DrawText(&chars[c.first], static_cast<int>(c.v[0].x), static_cast<int>(c.v[0].y), static_cast<int>(c.count), c.color);
+			break;
+		}
+	}
+
+	void ExecuteSoftware(const Command& c, SoftRaster& r) const {
+		switch (c.type) {
+		case Type::LINE:
+			r.Line(c.v[0], c.v[1], c.color);
+			break;
+		case Type::OUTLINE:
+			r.Outline(&points[c.first], static_cast<int>(c.count), c.color);
+			break;
+		case Type::POLY_LINES:
+			r.PolyLines(c.v[0], static_cast<int>(c.count), c.v[1].x, c.v[1].y, c.color);
+			break;
+		case Type::TRIANGLE:
+			r.Triangle(c.v[0], c.v[1], c.v[2], c.color);
+			break;
+		case Type::RECT:
+			r.Rect({ c.v[0].x, c.v[0].y, c.v[1].x, c.v[1].y }, c.color);
+			break;
+		case Type::RECT_LINES:
+			r.RectLines({ c.v[0].x, c.v[0].y, c.v[1].x, c.v[1].y }, c.v[2].x, c.color);
+			break;
+		case Type::TEXTURE:
+			r.Texture(c.texture, c.v[0], c.v[1].x, c.v[1].y, c.color);
+			break;
+		case Type::TEXT:
+			r.Text(&chars[c.first], static_cast<int>(c.v[0].x), static_cast<int>(c.v[0].y), static_cast<int>(c.count), c.color);
+			break;
+		}
+	}
+
+	RenderLayer layer = RenderLayer::WORLD;
+	uint8_t shader = 0;
+	uint16_t depth = 0;
+	bool sorting = true;
+	SoftRaster* soft = nullptr;
+	std::vector<Shader> shaders{ Shader{} }; // [0] is the default
+	std::vector<Command> commands;
+	std::vector<uint64_t> keys;
+	std::vector<Entry> order;
+	std::vector<Entry> scratch;
+	std::vector<Vector2> points;
+	std::vector<char> chars;
+	size_t flushed = 0;
+	size_t stateChanges = 0;
+};
+
+// --- DRAW CALL COUNTER ---
+// Counts the GL draw calls rlgl and the shaders make by swapping glad's entry points for
+// counting ones. Install() once the GL context exists.
+class DrawCallCounter {
+public:
+	static void Install() {
+		if (drawArrays) return;
+		drawArrays = glad_glDrawArrays;
+		drawElements = glad_glDrawElements;
+		drawArraysInstanced = glad_glDrawArraysInstanced;
+		drawElementsInstanced = glad_glDrawElementsInstanced;
+		if (drawArrays) glad_glDrawArrays = DrawArrays;
+		if (drawElements) glad_glDrawElements = DrawElements;
+		if (drawArraysInstanced) glad_glDrawArraysInstanced = DrawArraysInstanced;
+		if (drawElementsInstanced) glad_glDrawElementsInstanced = DrawElementsInstanced;
+	}
+
+	static uint64_t Total() {
+		return total;
+	}
+
+private:
+	static void GLAD_API_PTR DrawArrays(GLenum mode, GLint first, GLsizei count) {
+		total++;
+		drawArrays(mode, first, count);
+	}
+
+	static void GLAD_API_PTR DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+		total++;
+		drawElements(mode, count, type, indices);
+	}
+
+	static void GLAD_API_PTR DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+		total++;
+		drawArraysInstanced(mode, first, count, instances);
+	}
+
+	static void GLAD_API_PTR DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances) {
+		total++;
+		drawElementsInstanced(mode, count, type, indices, instances);
+	}
+
+	inline static PFNGLDRAWARRAYSPROC drawArrays = nullptr;
+	inline static PFNGLDRAWELEMENTSPROC drawElements = nullptr;
+	inline static PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced = nullptr;
+	inline static PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced = nullptr;
+	inline static uint64_t total = 0;
+};
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <raylib.h>
+#include <rlgl.h>
+#include "external/glad.h" // the loader lives in raylib, only the declarations are needed
+
+// raylib's own F12 capture is turned off in config.h; this is the only msf_gif in the build
+#if defined(_MSC_VER)
+#pragma warning(push, 0)
+#endif
+#define MSF_GIF_IMPL
+#include "external/msf_gif.h"
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+// --- SCREEN RECORDER ---
+// Screenshots (PNG/QOI) and GIF clips without stalling the frame. The finished back buffer
+// is optionally shrunk on the GPU, then read into one of RING pixel buffer objects. A
+// buffer is mapped a frame or more later, once its fence says the copy is done, so the
+// main thread only pays for a memcpy. Flipping and encoding happen on a worker thread.
+// When the encoder falls behind, frames are dropped rather than the game slowed down.
+
+enum class CaptureFormat { PNG, QOI, GIF };
+
+class ScreenRecorder {
+public:
+	static constexpr int RING = 3;
+	static constexpr size_t MAX_QUEUED = 16; // frames waiting for the encoder
+	static constexpr float GIF_FPS = 20.f;
+
+	~ScreenRecorder() {
+		Shutdown();
+	}
+
+	// Call with a GL context. 'downsample' divides both sides of the captured image.
+	bool Init(int downsample) {
+		if (!glad_glFenceSync || !glad_glMapBufferRange || !glad_glBlitFramebuffer) return false;
+		scale = downsample > 1 ? downsample : 1;
+		sourceW = GetRenderWidth();
+		sourceH = GetRenderHeight();
+		width = sourceW / scale;
+		height = sourceH / scale;
+		if (scale > 1) {
+			target = LoadRenderTexture(width, height);
+			if (target.id == 0) return false;
+		}
+		glGenBuffers(RING, pbos);
+		for (GLuint pbo : pbos) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, FrameBytes(), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		quit = false;
+		worker = std::thread([this] { WorkerLoop(); });
+		ready = true;
+		return true;
+	}
+
+	// Finishes the clip being recorded and waits for the encoder
+	void Shutdown() {
+		if (!ready) return;
+		if (recording) StopRecording();
+		if (frames > 0) {
+			TraceLog(LOG_INFO, "RECORDER: main thread %.3f ms/frame avg, %.2f ms max, %llu frames dropped",
+				totalCostMs / static_cast<double>(frames), maxCostMs, (unsigned long long)dropped);
+		}
+		Collect(true);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_one();
+		worker.join();
+		for (Slot& s : slots) {
+			if (s.fence) glDeleteSync(s.fence);
+			s = Slot{};
+		}
+		glDeleteBuffers(RING, pbos);
+		if (target.id != 0) UnloadRenderTexture(target);
+		target = RenderTexture2D{};
+		ready = false;
+	}
+
+	bool IsReady() const {
+		return ready;
+	}
+
+	bool IsRecording() const {
+		return recording;
+	}
+
+	// Saves the next finished frame
+	void Screenshot(CaptureFormat format) {
+		if (!ready || format == CaptureFormat::GIF) return;
+		stillRequested = true;
+		stillPath = TextFormat("screenshot%03d.%s", counter++, format == CaptureFormat::QOI ? "qoi" : "png");
+	}
+
+	void StartRecording() {
+		if (!ready || recording) return;
+		recording = true;
+		nextGifTime = GetTime();
+		lastGifTime = nextGifTime;
+		centisecondDebt = 0.0;
+		Job job;
+		job.kind = Job::GIF_BEGIN;
+		job.path = TextFormat("screenrec%03d.gif", counter++);
+		Push(std::move(job));
+		TraceLog(LOG_INFO, "RECORDER: recording %dx%d at %.0f fps", width, height, GIF_FPS);
+	}
+
+	void StopRecording() {
+		if (!recording) return;
+		recording = false;
+		Collect(true); // frames still in flight belong to this clip
+		Job job;
+		job.kind = Job::GIF_END;
+		Push(std::move(job));
+	}
+
+	// After EndDrawing(), before the buffers are swapped
+	void EndFrame() {
+		if (!ready) return;
+		double start = GetTime();
+		Collect(false);
+		if (stillRequested) {
+			if (Issue(Job::STILL, 0)) stillRequested = false;
+		}
+		else if (recording && start >= nextGifTime) {
+			// GIF delays are whole centiseconds, carry the rounding over to the next frame
+			centisecondDebt += (start - lastGifTime) * 100.0;
+			int cs = static_cast<int>(centisecondDebt);
+			if (cs < 1) cs = 1;
+			if (Issue(Job::GIF_FRAME, cs)) {
+				centisecondDebt -= cs;
+				lastGifTime = start;
+			}
+			nextGifTime += 1.0 / GIF_FPS;
+			if (nextGifTime < start) nextGifTime = start + 1.0 / GIF_FPS;
+		}
+		lastCostMs = (GetTime() - start) * 1000.0;
+		if (lastCostMs > maxCostMs) maxCostMs = lastCostMs;
+		totalCostMs += lastCostMs;
+		frames++;
+	}
+
+	// Main thread time spent in the last EndFrame() and the worst one so far
+	double LastCostMs() const {
+		return lastCostMs;
+	}
+
+	double MaxCostMs() const {
+		return maxCostMs;
+	}
+
+	uint64_t Dropped() const {
+		return dropped;
+	}
+
+private:
+	struct Job {
+		enum Kind { STILL, GIF_BEGIN, GIF_FRAME, GIF_END } kind = STILL;
+		std::vector<uint8_t> pixels; // bottom-up RGBA, as read back
+		int centiseconds = 0;
+		std::string path;
+	};
+
+	struct Slot {
+		GLsync fence = nullptr;
+		Job::Kind kind = Job::STILL;
+		int centiseconds = 0;
+		std::string path;
+	};
+
+	size_t FrameBytes() const {
+		return static_cast<size_t>(width) * height * 4;
+	}
+
+	// Starts an asynchronous readback of the back buffer into the next free PBO
+	bool Issue(Job::Kind kind, int centiseconds) {
+		Slot& s = slots[head];
+		if (s.fence || Queued() >= MAX_QUEUED) {
+			dropped++;
+			return false;
+		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		if (scale > 1) {
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.id);
+			glBlitFramebuffer(0, 0, sourceW, sourceH, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, target.id);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[head]);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		s.kind = kind;
+		s.centiseconds = centiseconds;
+		s.path = kind == Job::STILL ? stillPath : std::string();
+		head = (head + 1) % RING;
+		inFlight++;
+		return true;
+	}
+
+	// Hands finished readbacks to the worker, oldest first. Without 'wait' a copy that
+	// is still running stops the scan until the next frame.
+	void Collect(bool wait) {
+		while (inFlight > 0) {
+			Slot& s = slots[tail];
+			GLenum status = glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? WAIT_TIMEOUT_NS : 0);
+			if (status == GL_TIMEOUT_EXPIRED && !wait) return;
+			Job job;
+			job.kind = s.kind;
+			job.centiseconds = s.centiseconds;
+			job.path = std::move(s.path);
+			if (status != GL_WAIT_FAILED && status != GL_TIMEOUT_EXPIRED) {
+				job.pixels = TakeBuffer();
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[tail]);
+				if (const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, FrameBytes(), GL_MAP_READ_BIT)) {
+					memcpy(job.pixels.data(), data, FrameBytes());
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				Push(std::move(job));
+			}
+			else {
+				dropped++;
+			}
+			glDeleteSync(s.fence);
+			s = Slot{};
+			tail = (tail + 1) % RING;
+			inFlight--;
+		}
+	}
+
+	// Pixel buffers are recycled so recording doesn't allocate every frame
+	std::vector<uint8_t> TakeBuffer() {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<uint8_t> buffer;
+		if (!spare.empty()) {
+			buffer = std::move(spare.back());
+			spare.pop_back();
+		}
+		buffer.resize(FrameBytes());
+		return buffer;
+	}
+
+	size_t Queued() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return queue.size();
+	}
+
+	void Push(Job job) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(std::move(job));
+		}
+		wake.notify_one();
+	}
+
+	void WorkerLoop() {
+		MsfGifState gif{};
+		std::string gifPath;
+		for (;;) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this] { return quit || !queue.empty(); });
+				if (queue.empty()) break; // quit, and everything is encoded
+				job = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			int pitch = width * 4;
+			switch (job.kind) {
+			case Job::STILL: {
+				// OpenGL rows go bottom-up
+				std::vector<uint8_t> row(pitch);
+				for (int y = 0; y < height / 2; ++y) {
+					uint8_t* a = job.pixels.data() + static_cast<size_t>(y) * pitch;
+					uint8_t* b = job.pixels.data() + static_cast<size_t>(height - 1 - y) * pitch;
+					memcpy(row.data(), a, pitch);
+					memcpy(a, b, pitch);
+					memcpy(b, row.data(), pitch);
+				}
+				Image image{ job.pixels.data(), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+				ExportImage(image, job.path.c_str());
+			} break;
+			case Job::GIF_BEGIN:
+				gifPath = job.path;
+				msf_gif_begin(&gif, width, height);
+				break;
+			case Job::GIF_FRAME:
+				msf_gif_frame(&gif, job.pixels.data(), job.centiseconds, GIF_BIT_DEPTH, -pitch);
+				break;
+			case Job::GIF_END: {
+				MsfGifResult result = msf_gif_end(&gif);
+				if (result.data && SaveFileData(gifPath.c_str(), result.data, static_cast<int>(result.dataSize))) {
+					TraceLog(LOG_INFO, "RECORDER: %s written", gifPath.c_str());
+				}
+				msf_gif_free(result);
+			} break;
+			}
+
+			if (!job.pixels.empty()) {
+				std::lock_guard<std::mutex> lock(mutex);
+				spare.push_back(std::move(job.pixels));
+			}
+		}
+	}
+
+	static constexpr uint64_t WAIT_TIMEOUT_NS = 1'000'000'000;
+	static constexpr int GIF_BIT_DEPTH = 16;
+
+	bool ready = false;
+	int scale = 1;
+	int sourceW = 0;
+	int sourceH = 0;
+	int width = 0;
+	int height = 0;
+	RenderTexture2D target{};
+	GLuint pbos[RING] = {};
+	Slot slots[RING];
+	int head = 0;
+	int tail = 0;
+	int inFlight = 0;
+
+	bool recording = false;
+	bool stillRequested = false;
+	std::string stillPath;
+	int counter = 0;
+	double nextGifTime = 0.0;
+	double lastGifTime = 0.0;
+	double centisecondDebt = 0.0;
+	double lastCostMs = 0.0;
+	double maxCostMs = 0.0;
+	double totalCostMs = 0.0;
+	uint64_t frames = 0;
+	uint64_t dropped = 0;
+
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<Job> queue;
+	std::vector<std::vector<uint8_t>> spare;
+	bool quit = false;
+};
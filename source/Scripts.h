@@ -0,0 +1,267 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "TimingWheel.h"
+
+// --- SCRIPTS ---
+// Gameplay timing written as straight-line C++20 coroutines:
+//
+//   Task Spawner() {
+//       for (;;) {
+//           co_await Seconds(2.f);
+//           Spawn();
+//       }
+//   }
+//
+// A suspended script is one entry in the scheduler's timing wheel (or next-tick list)
+// and costs nothing until it is due. Frames come from a pooled allocator.
+
+// Size-classed free lists for coroutine frames. Main thread only.
+class CoroutineFramePool {
+public:
+	static CoroutineFramePool& Instance() {
+		static CoroutineFramePool inst;
+		return inst;
+	}
+
+	void* Allocate(size_t size) {
+		live++;
+		if (size > GRANULE * CLASSES) return ::operator new(size);
+		size_t cls = (size - 1) / GRANULE;
+		if (FreeBlock* b = freeLists[cls]) {
+			freeLists[cls] = b->next;
+			return b;
+		}
+		size_t bytes = (cls + 1) * GRANULE;
+		if (slabUsed + bytes > SLAB_SIZE || slabs.empty()) {
+			slabs.push_back(std::make_unique<unsigned char[]>(SLAB_SIZE));
+			slabUsed = 0;
+		}
+		void* p = slabs.back().get() + slabUsed;
+		slabUsed += bytes;
+		return p;
+	}
+
+	void Free(void* p, size_t size) {
+		live--;
+		if (size > GRANULE * CLASSES) {
+			::operator delete(p);
+			return;
+		}
+		size_t cls = (size - 1) / GRANULE;
+		FreeBlock* b = static_cast<FreeBlock*>(p);
+		b->next = freeLists[cls];
+		freeLists[cls] = b;
+	}
+
+	// Frames currently allocated
+	size_t Live() const {
+		return live;
+	}
+
+	size_t ReservedBytes() const {
+		return slabs.size() * SLAB_SIZE;
+	}
+
+private:
+	CoroutineFramePool() = default;
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	static constexpr size_t GRANULE = 64;
+	static constexpr size_t CLASSES = 16; // frames up to 1 KB are pooled
+	static constexpr size_t SLAB_SIZE = 64 * 1024;
+
+	std::array<FreeBlock*, CLASSES> freeLists{};
+	std::vector<std::unique_ptr<unsigned char[]>> slabs;
+	size_t slabUsed = 0;
+	size_t live = 0;
+};
+
+class ScriptScheduler;
+
+// Fire-and-forget script. Does nothing until handed to ScriptScheduler::Start().
+class Task {
+public:
+	struct promise_type {
+		ScriptScheduler* scheduler = nullptr;
+		uint32_t scope = 0;
+		uint32_t epoch = 0;
+
+		Task get_return_object() {
+			return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; } // finished scripts free themselves
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+
+		static void* operator new(size_t size) {
+			return CoroutineFramePool::Instance().Allocate(size);
+		}
+		static void operator delete(void* p, size_t size) {
+			CoroutineFramePool::Instance().Free(p, size);
+		}
+	};
+
+	using Handle = std::coroutine_handle<promise_type>;
+
+	Task(Task&& other) noexcept : handle(other.handle) {
+		other.handle = nullptr;
+	}
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+
+	~Task() {
+		if (handle) handle.destroy(); // never started
+	}
+
+	Handle Release() {
+		Handle h = handle;
+		handle = nullptr;
+		return h;
+	}
+
+private:
+	explicit Task(Handle h) : handle(h) {}
+
+	Handle handle;
+};
+
+// Runs scripts on a fixed-rate tick clock advanced by Update(dt)
+class ScriptScheduler {
+public:
+	static constexpr double TICK_RATE = 60.0;
+	static constexpr uint32_t MAX_SCOPES = 16;
+
+	ScriptScheduler() {
+		CoroutineFramePool::Instance(); // make sure the pool outlives us
+	}
+
+	~ScriptScheduler() {
+		Clear();
+	}
+
+	// Runs the script up to its first co_await. Scripts in the same scope can be
+	// cancelled together.
+	void Start(Task task, uint32_t scope = 0) {
+		Task::Handle h = task.Release();
+		h.promise().scheduler = this;
+		h.promise().scope = scope;
+		h.promise().epoch = epochs[scope];
+		Resume(h);
+	}
+
+	// Every script started in 'scope' so far is destroyed instead of resumed. O(1).
+	void Cancel(uint32_t scope) {
+		epochs[scope]++;
+	}
+
+	void Update(float dt) {
+		time += dt;
+		delta = dt;
+		running.swap(nextTick);
+		suspended -= running.size();
+		for (Task::Handle h : running) Resume(h);
+		running.clear();
+		wheel.Advance(static_cast<uint32_t>(time * TICK_RATE), [this](Task::Handle h) {
+			suspended--;
+			Resume(h);
+		});
+	}
+
+	// Destroys every suspended script
+	void Clear() {
+		wheel.ForEach([](Task::Handle h) { h.destroy(); });
+		wheel.Reset(wheel.Now());
+		for (Task::Handle h : nextTick) h.destroy();
+		nextTick.clear();
+		suspended = 0;
+	}
+
+	// Clear() and restart the clock at zero
+	void Reset() {
+		Clear();
+		wheel.Reset(0);
+		time = 0.0;
+		delta = 0.f;
+	}
+
+	double Time() const {
+		return time;
+	}
+
+	// dt of the Update() currently resuming scripts
+	float Delta() const {
+		return delta;
+	}
+
+	// Scripts waiting, including cancelled ones not yet due
+	size_t Suspended() const {
+		return suspended;
+	}
+
+	// Awaiter hooks
+	void ResumeAfter(Task::Handle h, float seconds) {
+		suspended++;
+		wheel.Schedule(static_cast<uint32_t>(ceil((time + seconds) * TICK_RATE)), h);
+	}
+
+	void ResumeNextTick(Task::Handle h) {
+		suspended++;
+		nextTick.push_back(h);
+	}
+
+private:
+	// The script either suspends again, registering itself through an awaiter, or finishes
+	void Resume(Task::Handle h) {
+		if (h.promise().epoch != epochs[h.promise().scope]) {
+			h.destroy(); // cancelled
+			return;
+		}
+		h.resume();
+	}
+
+	TimingWheel<Task::Handle> wheel;
+	std::vector<Task::Handle> nextTick;
+	std::vector<Task::Handle> running;
+	std::array<uint32_t, MAX_SCOPES> epochs{};
+	double time = 0.0;
+	float delta = 0.f;
+	size_t suspended = 0;
+};
+
+// co_await Seconds(x): resume on the first tick at least x seconds from now
+struct Seconds {
+	explicit Seconds(float s) : value(s) {}
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(Task::Handle h) const {
+		h.promise().scheduler->ResumeAfter(h, value);
+	}
+	void await_resume() const noexcept {}
+
+	float value;
+};
+
+// co_await NextTick: resume on the next Update()
+struct NextTickAwaiter {
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(Task::Handle h) const {
+		h.promise().scheduler->ResumeNextTick(h);
+	}
+	void await_resume() const noexcept {}
+};
+
+inline constexpr NextTickAwaiter NextTick{};
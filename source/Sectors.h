@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <raylib.h>
+
+// --- SECTORS ---
+// The world is a grid of square sectors. Only the window of sectors around the camera is
+// awake; everything else sleeps here, filed by position, and costs nothing per frame.
+// Sleepers move in straight lines, so waking one is a single fast-forward from the time it
+// was filed. Refresh() fast-forwards a time-sliced share of them every frame so that
+// sleepers drifting towards the awake window are handed back before they get close.
+//
+// T owns an entity and behaves like a pointer: item->GetPosition().
+
+template<typename T>
+class SectorGrid {
+public:
+	void Init(int columns, int rows, float sectorSize) {
+		cols = columns;
+		this->rows = rows;
+		size = sectorSize;
+		sectors.clear();
+		sectors.resize(static_cast<size_t>(cols) * rows);
+		activeLo = { 0, 0 };
+		activeHi = { -1, -1 };
+		sleeping = 0;
+		cursor = 0;
+	}
+
+	void Clear() {
+		Init(cols, rows, size);
+	}
+
+	int Columns() const { return cols; }
+	int Rows() const { return rows; }
+	float SectorSize() const { return size; }
+	size_t Sleeping() const { return sleeping; }
+	Vector2 WorldSize() const { return { cols * size, rows * size }; }
+
+	int SectorOf(Vector2 p) const {
+		int x = std::clamp(static_cast<int>(floorf(p.x / size)), 0, cols - 1);
+		int y = std::clamp(static_cast<int>(floorf(p.y / size)), 0, rows - 1);
+		return y * cols + x;
+	}
+
+	bool IsActive(int sector) const {
+		int x = sector % cols;
+		int y = sector / cols;
+		return x >= activeLo.x && x <= activeHi.x && y >= activeLo.y && y <= activeHi.y;
+	}
+
+	// World-space box of the awake window
+	Rectangle ActiveBounds() const {
+		return { activeLo.x * size, activeLo.y * size, (activeHi.x - activeLo.x + 1) * size, (activeHi.y - activeLo.y + 1) * size };
+	}
+
+	// Files 'item' under its current position. If that sector is awake it goes to 'woken'.
+	void Sleep(T item, double now, std::vector<T>& woken) {
+		int s = SectorOf(item->GetPosition());
+		if (IsActive(s)) {
+			woken.push_back(std::move(item));
+			return;
+		}
+		sectors[s].sleepers.push_back({ std::move(item), now });
+		sleeping++;
+	}
+
+	// Wakes the (2 * radius + 1)^2 sectors around 'center'. Sleepers of sectors that just
+	// woke up are fast-forwarded with advance(item, seconds) and appended to 'woken'.
+	// Returns false if the window did not change.
+	template<typename Advance>
+	bool SetActive(int center, int radius, double now, Advance&& advance, std::vector<T>& woken) {
+		Point lo{ std::max(center % cols - radius, 0), std::max(center / cols - radius, 0) };
+		Point hi{ std::min(center % cols + radius, cols - 1), std::min(center / cols + radius, rows - 1) };
+		if (lo.x == activeLo.x && lo.y == activeLo.y && hi.x == activeHi.x && hi.y == activeHi.y) return false;
+		activeLo = lo;
+		activeHi = hi;
+		for (int y = lo.y; y <= hi.y; ++y) {
+			for (int x = lo.x; x <= hi.x; ++x) {
+				Sector& s = sectors[y * cols + x];
+				for (Sleeper& z : s.sleepers) {
+					advance(z.item, static_cast<float>(now - z.since));
+					woken.push_back(std::move(z.item));
+				}
+				sleeping -= s.sleepers.size();
+				s.sleepers.clear();
+			}
+		}
+		return true;
+	}
+
+	// Fast-forwards sleepers round-robin, whole sectors at a time, until at least 'budget'
+	// were processed. Anything that drifted into the awake window goes to 'woken'.
+	template<typename Advance>
+	size_t Refresh(double now, size_t budget, Advance&& advance, std::vector<T>& woken) {
+		size_t processed = 0;
+		for (size_t visited = 0; visited < sectors.size() && processed < budget; ++visited) {
+			int index = static_cast<int>(cursor);
+			cursor = (cursor + 1) % sectors.size();
+			if (IsActive(index)) continue;
+			std::vector<Sleeper>& list = sectors[index].sleepers;
+			processed += list.size();
+			for (size_t i = 0; i < list.size();) {
+				Sleeper& z = list[i];
+				advance(z.item, static_cast<float>(now - z.since));
+				z.since = now;
+				int s = SectorOf(z.item->GetPosition());
+				if (s == index) {
+					++i;
+					continue;
+				}
+				// Moved on: swap-remove and refile
+				Sleeper moved = std::move(z);
+				if (i + 1 < list.size()) z = std::move(list.back());
+				list.pop_back();
+				if (IsActive(s)) {
+					woken.push_back(std::move(moved.item));
+					sleeping--;
+				}
+				else {
+					sectors[s].sleepers.push_back(std::move(moved));
+				}
+			}
+		}
+		return processed;
+	}
+
+private:
+	struct Point {
+		int x;
+		int y;
+	};
+
+	struct Sleeper {
+		T item;
+		double since; // sim time the item's state is valid for
+	};
+
+	struct Sector {
+		std::vector<Sleeper> sleepers;
+	};
+
+	int cols = 1;
+	int rows = 1;
+	float size = 1.f;
+	std::vector<Sector> sectors;
+	Point activeLo{ 0, 0 };
+	Point activeHi{ -1, -1 };
+	size_t sleeping = 0;
+	size_t cursor = 0;
+};
@@ -0,0 +1,800 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <raylib.h>
+
+#include "Jobs.h"
+
+// --- SOFTWARE RASTERIZER ---
+// CPU stand-in for the GL path, for machines without a GPU. RenderQueue replays into it
+// instead of raylib (RenderQueue::SetSoftware()), so the game's draw code runs unchanged.
+// Draws are transformed to screen space and recorded; Flush() bins them into TILE x TILE
+// tiles and rasterizes the tiles on the JobPool. A tile draws its primitives in
+// submission order and owns its pixels, so the image does not depend on the worker
+// count. Spans are filled and blended 8 pixels at a time.
+//
+// Close to raylib, not identical: 1 px lines, coverage at pixel centres without
+// antialiasing, textures sampled nearest from a box-filtered mip level instead of
+// bilinear, blending in 8-bit integers. Shaders (SDF outlines, composite, lights) are GL
+// only and are skipped. The framebuffer is opaque RGBA8.
+
+enum class SoftPrimitive : uint8_t { LINE, RECT, TRIANGLE, TEXTURE, TEXT, COUNT };
+static constexpr int SOFT_PRIMITIVES = static_cast<int>(SoftPrimitive::COUNT);
+
+inline const char* SoftPrimitiveName(SoftPrimitive p) {
+	switch (p) {
+	case SoftPrimitive::LINE: return "line";
+	case SoftPrimitive::RECT: return "rect";
+	case SoftPrimitive::TRIANGLE: return "triangle";
+	case SoftPrimitive::TEXTURE: return "texture";
+	case SoftPrimitive::TEXT: return "text";
+	default: return "?";
+	}
+}
+
+class SoftRaster {
+public:
+	static constexpr int TILE = 64;
+	static constexpr int MIN_TILES_PER_CHUNK = 4;
+
+	void Init(int w, int h) {
+		width = w;
+		height = h;
+		cols = (w + TILE - 1) / TILE;
+		rows = (h + TILE - 1) / TILE;
+		pixels.assign(static_cast<size_t>(w) * h, ALPHA);
+		bins.assign(static_cast<size_t>(cols) * rows, {});
+		if (font.levels.empty()) BuildFont();
+		ResetCamera();
+	}
+
+	int Width() const { return width; }
+	int Height() const { return height; }
+
+	// Right away; anything recorded and not flushed yet is dropped
+	void Clear(Color c) {
+		prims.clear();
+		std::fill(pixels.begin(), pixels.end(), Pack(c) | ALPHA);
+	}
+
+	// BeginMode2D() / EndMode2D(): applies to what is recorded from now on
+	void SetCamera(const Camera2D& c) {
+		float r = c.rotation * DEG2RAD;
+		float cs = cosf(r) * c.zoom;
+		float sn = sinf(r) * c.zoom;
+		xf = { cs, -sn, c.offset.x - (cs * c.target.x - sn * c.target.y),
+			sn, cs, c.offset.y - (sn * c.target.x + cs * c.target.y) };
+	}
+
+	void ResetCamera() {
+		xf = { 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+	}
+
+	// CPU copy of an image to draw with Texture(), under an id of its own. There is no
+	// GL to LoadTexture() from, so the returned handle is what the game draws with.
+	Texture2D AddTexture(const Image& image) {
+		Image copy = ImageCopy(image);
+		ImageFormat(&copy, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+		TextureData& t = textures[nextTexture];
+		t.levels.clear();
+		Level& base = t.levels.emplace_back();
+		base.w = copy.width;
+		base.h = copy.height;
+		const uint32_t* src = static_cast<const uint32_t*>(copy.data);
+		base.texels.assign(src, src + static_cast<size_t>(copy.width) * copy.height);
+		UnloadImage(copy);
+		BuildMips(t);
+		return Texture2D{ nextTexture++, image.width, image.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+	}
+
+	// --- Drawing, same arguments as the raylib call in the comment ---
+
+	// DrawLineV()
+	void Line(Vector2 a, Vector2 b, Color c) {
+		stats.primitive[Index(SoftPrimitive::LINE)].calls++;
+		AddLine(SoftPrimitive::LINE, ToScreen(a), ToScreen(b), Pack(c));
+	}
+
+	// DrawLineV() from each point to the next, closed
+	void Outline(const Vector2* p, int count, Color c) {
+		stats.primitive[Index(SoftPrimitive::LINE)].calls++;
+		for (int i = 0; i < count; ++i) {
+			AddLine(SoftPrimitive::LINE, ToScreen(p[i]), ToScreen(p[(i + 1) % count]), Pack(c));
+		}
+	}
+
+	// DrawPolyLines()
+	void PolyLines(Vector2 center, int sides, float radius, float rotation, Color c) {
+		stats.primitive[Index(SoftPrimitive::LINE)].calls++;
+		sides = std::max(sides, 3);
+		float angle = rotation * DEG2RAD;
+		float step = 360.0f / sides * DEG2RAD;
+		for (int i = 0; i < sides; ++i) {
+			Vector2 a = { center.x + cosf(angle) * radius, center.y + sinf(angle) * radius };
+			Vector2 b = { center.x + cosf(angle + step) * radius, center.y + sinf(angle + step) * radius };
+			AddLine(SoftPrimitive::LINE, ToScreen(a), ToScreen(b), Pack(c));
+			angle += step;
+		}
+	}
+
+	// DrawTriangle(), either winding
+	void Triangle(Vector2 a, Vector2 b, Vector2 c, Color color) {
+		stats.primitive[Index(SoftPrimitive::TRIANGLE)].calls++;
+		Vector2 v[3] = { ToScreen(a), ToScreen(b), ToScreen(c) };
+		AddPolygon(SoftPrimitive::TRIANGLE, v, 3, Pack(color));
+	}
+
+	// DrawRectangleRec()
+	void Rect(Rectangle r, Color c) {
+		stats.primitive[Index(SoftPrimitive::RECT)].calls++;
+		AddRect(r, Pack(c));
+	}
+
+	// DrawRectangleLinesEx()
+	void RectLines(Rectangle r, float thick, Color c) {
+		stats.primitive[Index(SoftPrimitive::RECT)].calls++;
+		if (thick > r.width || thick > r.height) {
+			if (r.width > r.height) thick = r.height / 2;
+			else if (r.width < r.height) thick = r.width / 2;
+		}
+		uint32_t color = Pack(c);
+		AddRect({ r.x, r.y, r.width, thick }, color);
+		AddRect({ r.x, r.y - thick + r.height, r.width, thick }, color);
+		AddRect({ r.x, r.y + thick, thick, r.height - thick * 2.f }, color);
+		AddRect({ r.x - thick + r.width, r.y + thick, thick, r.height - thick * 2.f }, color);
+	}
+
+	// DrawTextureEx(); textures nothing was added under draw nothing
+	void Texture(Texture2D t, Vector2 position, float rotation, float scale, Color tint) {
+		stats.primitive[Index(SoftPrimitive::TEXTURE)].calls++;
+		auto it = textures.find(t.id);
+		if (it == textures.end()) {
+			stats.missingTextures++;
+			return;
+		}
+		const Level& base = it->second.levels[0];
+		float r = rotation * DEG2RAD;
+		Vector2 u = { cosf(r) * base.w * scale, sinf(r) * base.w * scale };
+		Vector2 v = { -sinf(r) * base.h * scale, cosf(r) * base.h * scale };
+		AddImage(SoftPrimitive::TEXTURE, it->second, position, u, v, { 0, 0, static_cast<float>(base.w), static_cast<float>(base.h) }, Pack(tint));
+	}
+
+	// DrawText() with raylib's default font
+	void Text(const char* text, int x, int y, int fontSize, Color c) {
+		stats.primitive[Index(SoftPrimitive::TEXT)].calls++;
+		fontSize = std::max(fontSize, FONT_HEIGHT);
+		float scale = static_cast<float>(fontSize) / FONT_HEIGHT;
+		float spacing = static_cast<float>(fontSize / FONT_HEIGHT);
+		float ox = 0.f;
+		float oy = 0.f;
+		for (const char* p = text; *p; ++p) {
+			unsigned char ch = static_cast<unsigned char>(*p);
+			if (ch == '\n') {
+				oy += LINE_SPACING;
+				ox = 0.f;
+				continue;
+			}
+			int glyph = ch >= 32 ? ch - 32 : '?' - 32;
+			const Rectangle& src = glyphs[glyph];
+			if (ch != ' ' && ch != '\t') {
+				AddImage(SoftPrimitive::TEXT, font, { x + ox, y + oy }, { src.width * scale, 0.f }, { 0.f, src.height * scale }, src, Pack(c));
+			}
+			ox += src.width * scale + spacing;
+		}
+	}
+
+	// Rasterizes everything recorded since the last Flush() or Clear()
+	void Flush() {
+		if (prims.empty()) return;
+		Clock::time_point t0 = Clock::now();
+		for (std::vector<uint32_t>& bin : bins) bin.clear();
+		for (size_t i = 0; i < prims.size(); ++i) {
+			const Prim& p = prims[i];
+			if (p.x0 >= p.x1 || p.y0 >= p.y1) continue;
+			for (int ty = p.y0 / TILE; ty <= (p.y1 - 1) / TILE; ++ty) {
+				for (int tx = p.x0 / TILE; tx <= (p.x1 - 1) / TILE; ++tx) {
+					bins[static_cast<size_t>(ty) * cols + tx].push_back(static_cast<uint32_t>(i));
+				}
+			}
+		}
+		Clock::time_point t1 = Clock::now();
+
+		workerStats.assign(JobPool::Instance().Workers(), WorkerStats{});
+		JobPool::Instance().ParallelFor(cols * rows, MIN_TILES_PER_CHUNK, [this](int begin, int end, int worker) {
+			for (int t = begin; t < end; ++t) RasterTile(t, workerStats[worker]);
+		});
+		Clock::time_point t2 = Clock::now();
+
+		for (const WorkerStats& w : workerStats) {
+			for (int k = 0; k < SOFT_PRIMITIVES; ++k) {
+				stats.primitive[k].pixels += w.pixels[k];
+				stats.primitive[k].ms += w.ns[k] * 1e-6;
+			}
+		}
+		stats.binMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+		stats.rasterMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+		prims.clear();
+	}
+
+	// Since the last TakeStats(). Calls are the raylib-level draws above, primitives what
+	// they became (a text call is a quad per glyph). Pixels count every blend, so overdraw
+	// counts too; they do not depend on timing and make a deterministic cost measure.
+	struct PrimitiveStats {
+		uint64_t calls = 0;
+		uint64_t primitives = 0;
+		uint64_t pixels = 0;
+		double ms = 0.0; // rasterizing, summed over workers
+	};
+
+	struct Stats {
+		PrimitiveStats primitive[SOFT_PRIMITIVES];
+		double binMs = 0.0;
+		double rasterMs = 0.0; // wall clock
+		uint64_t missingTextures = 0;
+	};
+
+	Stats TakeStats() {
+		Stats s = stats;
+		stats = Stats{};
+		return s;
+	}
+
+	// RGBA8, row by row
+	const uint32_t* Pixels() const { return pixels.data(); }
+
+	bool ExportPng(const char* path) const {
+		Image image = { const_cast<uint32_t*>(pixels.data()), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+		return ExportImage(image, path);
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr uint32_t ALPHA = 0xFF000000u;
+	static constexpr int FONT_HEIGHT = 10;
+	static constexpr float LINE_SPACING = 15.f; // rtext.c textLineSpacing
+
+	enum class Shape : uint8_t { LINE, POLYGON, IMAGE };
+
+	struct Level {
+		int w = 0;
+		int h = 0;
+		std::vector<uint32_t> texels;
+	};
+
+	struct TextureData {
+		std::vector<Level> levels; // [0] is the image, then halves down to 1 x 1
+	};
+
+	struct Prim {
+		SoftPrimitive kind;
+		Shape shape;
+		uint8_t count;       // POLYGON, IMAGE: vertices
+		uint32_t color;      // IMAGE: tint
+		Vector2 v[4];        // screen space
+		int x0, y0, x1, y1;  // pixels it may touch, [x0, x1) x [y0, y1)
+		const Level* level;  // IMAGE: texel (u, v) = (su.x, sv.x) * x + (su.y, sv.y) * y + (su.z, sv.z)
+		Vector3 su, sv;
+	};
+
+	struct Box {
+		int x0, y0, x1, y1;
+	};
+
+	struct alignas(64) WorkerStats {
+		uint64_t ns[SOFT_PRIMITIVES] = {};
+		uint64_t pixels[SOFT_PRIMITIVES] = {};
+	};
+
+	struct Affine {
+		float a, b, tx, c, d, ty;
+	};
+
+	static constexpr int Index(SoftPrimitive p) { return static_cast<int>(p); }
+
+	static uint32_t Pack(Color c) {
+		return c.r | static_cast<uint32_t>(c.g) << 8 | static_cast<uint32_t>(c.b) << 16 | static_cast<uint32_t>(c.a) << 24;
+	}
+
+	Vector2 ToScreen(Vector2 p) const {
+		return { xf.a * p.x + xf.b * p.y + xf.tx, xf.c * p.x + xf.d * p.y + xf.ty };
+	}
+
+	Vector2 ToScreenDir(Vector2 p) const {
+		return { xf.a * p.x + xf.b * p.y, xf.c * p.x + xf.d * p.y };
+	}
+
+	// Pixel bounds of v[0..count), clamped to the screen
+	void Bound(Prim& p, float pad) const {
+		float lx = p.v[0].x, hx = p.v[0].x, ly = p.v[0].y, hy = p.v[0].y;
+		for (int i = 1; i < p.count; ++i) {
+			lx = std::min(lx, p.v[i].x);
+			hx = std::max(hx, p.v[i].x);
+			ly = std::min(ly, p.v[i].y);
+			hy = std::max(hy, p.v[i].y);
+		}
+		p.x0 = static_cast<int>(std::clamp(floorf(lx - pad), 0.f, static_cast<float>(width)));
+		p.x1 = static_cast<int>(std::clamp(ceilf(hx + pad), 0.f, static_cast<float>(width)));
+		p.y0 = static_cast<int>(std::clamp(floorf(ly - pad), 0.f, static_cast<float>(height)));
+		p.y1 = static_cast<int>(std::clamp(ceilf(hy + pad), 0.f, static_cast<float>(height)));
+	}
+
+	void AddLine(SoftPrimitive kind, Vector2 a, Vector2 b, uint32_t color) {
+		if ((color >> 24) == 0) return;
+		Prim& p = prims.emplace_back();
+		p.kind = kind;
+		p.shape = Shape::LINE;
+		p.count = 2;
+		p.color = color;
+		p.v[0] = a;
+		p.v[1] = b;
+		Bound(p, 1.f);
+		stats.primitive[Index(kind)].primitives++;
+	}
+
+	void AddPolygon(SoftPrimitive kind, const Vector2* v, int count, uint32_t color) {
+		if ((color >> 24) == 0) return;
+		Prim& p = prims.emplace_back();
+		p.kind = kind;
+		p.shape = Shape::POLYGON;
+		p.count = static_cast<uint8_t>(count);
+		p.color = color;
+		std::copy(v, v + count, p.v);
+		Bound(p, 0.f);
+		stats.primitive[Index(kind)].primitives++;
+	}
+
+	void AddRect(Rectangle r, uint32_t color) {
+		Vector2 v[4] = { ToScreen({ r.x, r.y }), ToScreen({ r.x + r.width, r.y }),
+			ToScreen({ r.x + r.width, r.y + r.height }), ToScreen({ r.x, r.y + r.height }) };
+		AddPolygon(SoftPrimitive::RECT, v, 4, color);
+	}
+
+	// The parallelogram origin + s * u + t * v, s and t in [0, 1], showing 'src' (texels
+	// of level 0) of 't'. Picks the mip level closest to one texel per pixel.
+	void AddImage(SoftPrimitive kind, const TextureData& t, Vector2 origin, Vector2 u, Vector2 v, Rectangle src, uint32_t tint) {
+		if ((tint >> 24) == 0) return;
+		Vector2 o = ToScreen(origin);
+		u = ToScreenDir(u);
+		v = ToScreenDir(v);
+		float det = u.x * v.y - v.x * u.y;
+		if (fabsf(det) < 1e-6f) return;
+
+		float texelsPerPixel = std::max(src.width / sqrtf(u.x * u.x + u.y * u.y), src.height / sqrtf(v.x * v.x + v.y * v.y));
+		int level = 0;
+		while (level + 1 < static_cast<int>(t.levels.size()) && texelsPerPixel >= 2.f) {
+			texelsPerPixel *= 0.5f;
+			level++;
+		}
+		float k = 1.f / static_cast<float>(1 << level);
+
+		Prim& p = prims.emplace_back();
+		p.kind = kind;
+		p.shape = Shape::IMAGE;
+		p.count = 4;
+		p.color = tint;
+		p.v[0] = o;
+		p.v[1] = { o.x + u.x, o.y + u.y };
+		p.v[2] = { o.x + u.x + v.x, o.y + u.y + v.y };
+		p.v[3] = { o.x + v.x, o.y + v.y };
+		p.level = &t.levels[level];
+		// s = (v.y * dx - v.x * dy) / det, t = (u.x * dy - u.y * dx) / det, relative to o
+		float sw = src.width * k, sh = src.height * k;
+		p.su = { sw * v.y / det, -sw * v.x / det, 0.f };
+		p.sv = { -sh * u.y / det, sh * u.x / det, 0.f };
+		p.su.z = src.x * k - p.su.x * o.x - p.su.y * o.y;
+		p.sv.z = src.y * k - p.sv.x * o.x - p.sv.y * o.y;
+		Bound(p, 0.f);
+		stats.primitive[Index(kind)].primitives++;
+	}
+
+	// Each level halves the previous one, colours weighted by alpha so transparent texels
+	// do not darken the edges
+	static void BuildMips(TextureData& t) {
+		while (t.levels.back().w > 1 || t.levels.back().h > 1) {
+			const Level& prev = t.levels.back();
+			Level next;
+			next.w = std::max(prev.w / 2, 1);
+			next.h = std::max(prev.h / 2, 1);
+			next.texels.resize(static_cast<size_t>(next.w) * next.h);
+			for (int y = 0; y < next.h; ++y) {
+				for (int x = 0; x < next.w; ++x) {
+					uint32_t sum[4] = {};
+					for (int k = 0; k < 4; ++k) {
+						int sx = std::min(x * 2 + (k & 1), prev.w - 1);
+						int sy = std::min(y * 2 + (k >> 1), prev.h - 1);
+						uint32_t c = prev.texels[static_cast<size_t>(sy) * prev.w + sx];
+						uint32_t a = c >> 24;
+						for (int ch = 0; ch < 3; ++ch) sum[ch] += ((c >> (ch * 8)) & 0xFF) * a;
+						sum[3] += a;
+					}
+					uint32_t out = (sum[3] / 4) << 24;
+					if (sum[3]) {
+						for (int ch = 0; ch < 3; ++ch) out |= (sum[ch] / sum[3]) << (ch * 8);
+					}
+					next.texels[static_cast<size_t>(y) * next.w + x] = out;
+				}
+			}
+			t.levels.push_back(std::move(next));
+		}
+	}
+
+	void BuildFont();
+
+	// --- Rasterizing ---
+
+	void RasterTile(int tile, WorkerStats& ws) {
+		const std::vector<uint32_t>& list = bins[tile];
+		if (list.empty()) return;
+		int tx = tile % cols;
+		int ty = tile / cols;
+		Box box{ tx * TILE, ty * TILE, std::min((tx + 1) * TILE, width), std::min((ty + 1) * TILE, height) };
+
+		// Timed in runs of one kind, the queue's sorting makes those long
+		SoftPrimitive running = prims[list[0]].kind;
+		Clock::time_point start = Clock::now();
+		for (uint32_t i : list) {
+			const Prim& p = prims[i];
+			if (p.kind != running) {
+				Clock::time_point now = Clock::now();
+				ws.ns[Index(running)] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+				start = now;
+				running = p.kind;
+			}
+			switch (p.shape) {
+			case Shape::LINE: ws.pixels[Index(p.kind)] += DrawLine(p, box); break;
+			case Shape::POLYGON: ws.pixels[Index(p.kind)] += DrawPolygon(p, box); break;
+			case Shape::IMAGE: ws.pixels[Index(p.kind)] += DrawImage(p, box); break;
+			}
+		}
+		ws.ns[Index(running)] += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	}
+
+	uint32_t* Row(int y) {
+		return &pixels[static_cast<size_t>(y) * width];
+	}
+
+	// One pixel per column (or row, whichever the line is longer along) whose centre the
+	// line passes, from the line's own endpoints so every tile picks the same pixels
+	uint64_t DrawLine(const Prim& p, const Box& b) {
+		Vector2 a = p.v[0];
+		Vector2 c = p.v[1];
+		float dx = c.x - a.x;
+		float dy = c.y - a.y;
+		bool steep = fabsf(dy) > fabsf(dx);
+		if (steep) {
+			std::swap(a.x, a.y);
+			std::swap(c.x, c.y);
+			std::swap(dx, dy);
+		}
+		if (dx == 0.f) return 0;
+		if (a.x > c.x) std::swap(a, c);
+		float slope = dy / dx;
+		int lo = steep ? b.y0 : b.x0, hi = steep ? b.y1 : b.x1;
+		int olo = steep ? b.x0 : b.y0, ohi = steep ? b.x1 : b.y1;
+		int s0 = static_cast<int>(ceilf(std::max(a.x - 0.5f, lo - 1.f)));
+		int s1 = static_cast<int>(ceilf(std::min(c.x - 0.5f, static_cast<float>(hi))));
+		s0 = std::max(s0, lo);
+		s1 = std::min(s1, hi);
+		uint64_t n = 0;
+		for (int s = s0; s < s1; ++s) {
+			float fo = floorf(a.y + (s + 0.5f - a.x) * slope);
+			if (fo < olo || fo >= ohi) continue;
+			int o = static_cast<int>(fo);
+			uint32_t& px = steep ? Row(s)[o] : Row(o)[s];
+			px = BlendPixel(px, p.color);
+			n++;
+		}
+		return n;
+	}
+
+	// Calls fn(y, x0, x1) for every row of the convex polygon inside 'b', covering the
+	// pixels whose centres are inside. Edges are walked top to bottom so a shared edge
+	// splits pixels the same way for both sides.
+	template<typename Fn>
+	static void ForEachSpan(const Prim& p, const Box& b, Fn&& fn) {
+		int y0 = std::max(p.y0, b.y0);
+		int y1 = std::min(p.y1, b.y1);
+		for (int y = y0; y < y1; ++y) {
+			float yc = y + 0.5f;
+			float xl = INFINITY, xr = -INFINITY;
+			for (int e = 0; e < p.count; ++e) {
+				Vector2 a = p.v[e];
+				Vector2 c = p.v[(e + 1) % p.count];
+				if (a.y > c.y) std::swap(a, c);
+				if (!(a.y <= yc && yc < c.y)) continue;
+				float x = a.x + (yc - a.y) * (c.x - a.x) / (c.y - a.y);
+				xl = std::min(xl, x);
+				xr = std::max(xr, x);
+			}
+			if (!(xl < xr)) continue;
+			int x0 = std::max(static_cast<int>(ceilf(std::max(xl - 0.5f, b.x0 - 1.f))), b.x0);
+			int x1 = std::min(static_cast<int>(ceilf(std::min(xr - 0.5f, static_cast<float>(b.x1)))), b.x1);
+			if (x0 < x1) fn(y, x0, x1);
+		}
+	}
+
+	uint64_t DrawPolygon(const Prim& p, const Box& b) {
+		uint64_t n = 0;
+		ForEachSpan(p, b, [&](int y, int x0, int x1) {
+			FillSpan(Row(y) + x0, x1 - x0, p.color);
+			n += x1 - x0;
+		});
+		return n;
+	}
+
+	uint64_t DrawImage(const Prim& p, const Box& b) {
+		uint64_t n = 0;
+		uint32_t texels[TILE];
+		ForEachSpan(p, b, [&](int y, int x0, int x1) {
+			Sample(p, y, x0, x1 - x0, texels);
+			BlendSpan(Row(y) + x0, texels, x1 - x0);
+			n += x1 - x0;
+		});
+		return n;
+	}
+
+	// Nearest texels for pixels [x0, x0 + n) of row y, tinted
+	static void Sample(const Prim& p, int y, int x0, int n, uint32_t* out) {
+		const Level& l = *p.level;
+		float yc = y + 0.5f;
+		float ub = p.su.y * yc + p.su.z;
+		float vb = p.sv.y * yc + p.sv.z;
+		float maxU = static_cast<float>(l.w - 1);
+		float maxV = static_cast<float>(l.h - 1);
+		bool tinted = p.color != 0xFFFFFFFFu;
+		int i = 0;
+#if defined(__AVX2__)
+		const __m256 centre = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 su = _mm256_set1_ps(p.su.x);
+		const __m256 sv = _mm256_set1_ps(p.sv.x);
+		const __m256 u0 = _mm256_set1_ps(ub);
+		const __m256 v0 = _mm256_set1_ps(vb);
+		const __m256 hiU = _mm256_set1_ps(maxU);
+		const __m256 hiV = _mm256_set1_ps(maxV);
+		const __m256i stride = _mm256_set1_epi32(l.w);
+		const int* texels = reinterpret_cast<const int*>(l.texels.data());
+		for (; i + 8 <= n; i += 8) {
+			__m256 x = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x0 + i)), centre);
+			__m256 u = _mm256_add_ps(_mm256_mul_ps(su, x), u0);
+			__m256 v = _mm256_add_ps(_mm256_mul_ps(sv, x), v0);
+			u = _mm256_min_ps(_mm256_max_ps(_mm256_floor_ps(u), zero), hiU);
+			v = _mm256_min_ps(_mm256_max_ps(_mm256_floor_ps(v), zero), hiV);
+			__m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(v), stride), _mm256_cvttps_epi32(u));
+			__m256i t = _mm256_i32gather_epi32(texels, index, 4);
+			if (tinted) t = Modulate8(t, _mm256_set1_epi32(static_cast<int>(p.color)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), t);
+		}
+#endif
+		for (; i < n; ++i) {
+			float x = static_cast<float>(x0 + i) + 0.5f;
+			float u = std::min(std::max(floorf(p.su.x * x + ub), 0.f), maxU);
+			float v = std::min(std::max(floorf(p.sv.x * x + vb), 0.f), maxV);
+			uint32_t t = l.texels[static_cast<size_t>(v) * l.w + static_cast<size_t>(u)];
+			out[i] = tinted ? Modulate(t, p.color) : t;
+		}
+	}
+
+	// x * y / 255 per channel, rounded
+	static uint32_t Modulate(uint32_t x, uint32_t y) {
+		uint32_t out = 0;
+		for (int sh = 0; sh < 32; sh += 8) {
+			uint32_t t = ((x >> sh) & 0xFF) * ((y >> sh) & 0xFF) + 128;
+			out |= ((t + (t >> 8)) >> 8) << sh;
+		}
+		return out;
+	}
+
+	// src over dst with src's alpha, like BLEND_ALPHA; the result stays opaque
+	static uint32_t BlendPixel(uint32_t dst, uint32_t src) {
+		uint32_t a = src >> 24;
+		if (a == 255) return src;
+		if (a == 0) return dst;
+		uint32_t out = ALPHA;
+		for (int sh = 0; sh < 24; sh += 8) {
+			uint32_t t = ((src >> sh) & 0xFF) * a + ((dst >> sh) & 0xFF) * (255 - a) + 128;
+			out |= ((t + (t >> 8)) >> 8) << sh;
+		}
+		return out;
+	}
+
+#if defined(__AVX2__)
+	// The same two as above for 8 pixels, with channels widened to 16 bits
+	static __m256i Modulate8(__m256i x, __m256i y) {
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i half = _mm256_set1_epi16(128);
+		auto mul = [&](__m256i a, __m256i b) {
+			__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), half);
+			return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+		};
+		__m256i lo = mul(_mm256_unpacklo_epi8(x, zero), _mm256_unpacklo_epi8(y, zero));
+		__m256i hi = mul(_mm256_unpackhi_epi8(x, zero), _mm256_unpackhi_epi8(y, zero));
+		return _mm256_packus_epi16(lo, hi);
+	}
+
+	static __m256i Blend8(__m256i dst, __m256i src) {
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i full = _mm256_set1_epi16(255);
+		const __m256i half = _mm256_set1_epi16(128);
+		auto mix = [&](__m256i s, __m256i d) {
+			__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+			__m256i t = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, _mm256_sub_epi16(full, a))), half);
+			return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+		};
+		__m256i lo = mix(_mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(dst, zero));
+		__m256i hi = mix(_mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(dst, zero));
+		return _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(static_cast<int>(ALPHA)));
+	}
+#endif
+
+	static void FillSpan(uint32_t* dst, int n, uint32_t color) {
+		uint32_t a = color >> 24;
+		int i = 0;
+		if (a == 255) {
+#if defined(__AVX2__)
+			const __m256i c = _mm256_set1_epi32(static_cast<int>(color));
+			for (; i + 8 <= n; i += 8) _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), c);
+#endif
+			for (; i < n; ++i) dst[i] = color;
+			return;
+		}
+#if defined(__AVX2__)
+		const __m256i c = _mm256_set1_epi32(static_cast<int>(color));
+		for (; i + 8 <= n; i += 8) {
+			__m256i* p = reinterpret_cast<__m256i*>(dst + i);
+			_mm256_storeu_si256(p, Blend8(_mm256_loadu_si256(p), c));
+		}
+#endif
+		for (; i < n; ++i) dst[i] = BlendPixel(dst[i], color);
+	}
+
+	// Sprites are mostly fully opaque or fully clear, so whole groups of 8 usually skip
+	// the blend
+	static void BlendSpan(uint32_t* dst, const uint32_t* src, int n) {
+		int i = 0;
+#if defined(__AVX2__)
+		const __m256i opaque = _mm256_set1_epi32(static_cast<int>(ALPHA));
+		for (; i + 8 <= n; i += 8) {
+			__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			__m256i a = _mm256_and_si256(s, opaque);
+			if (_mm256_testz_si256(a, a)) continue;
+			__m256i* p = reinterpret_cast<__m256i*>(dst + i);
+			if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, opaque)) == -1) _mm256_storeu_si256(p, s);
+			else _mm256_storeu_si256(p, Blend8(_mm256_loadu_si256(p), s));
+		}
+#endif
+		for (; i < n; ++i) dst[i] = BlendPixel(dst[i], src[i]);
+	}
+
+	int width = 0;
+	int height = 0;
+	int cols = 0;
+	int rows = 0;
+	std::vector<uint32_t> pixels;
+	std::vector<Prim> prims;
+	std::vector<std::vector<uint32_t>> bins; // prims per tile, in submission order
+	std::vector<WorkerStats> workerStats;
+	std::unordered_map<unsigned int, TextureData> textures; // nodes do not move, prims point into them
+	unsigned int nextTexture = 1;
+	TextureData font;
+	Rectangle glyphs[224]{};
+	Affine xf{ 1.f, 0.f, 0.f, 0.f, 1.f, 0.f };
+	Stats stats;
+};
+
+// rtext.c's LoadFontDefault() data: the 128 x 128 atlas at 1 bit per texel (the rest
+// is zeros), and the glyph widths from ' ' on
+namespace SoftFont {
+	inline constexpr uint32_t BITS[] = {
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00200020, 0x0001b000, 0x00000000, 0x00000000,
+		0x8ef92520, 0x00020a00, 0x7dbe8000, 0x1f7df45f, 0x4a2bf2a0, 0x0852091e, 0x41224000, 0x10041450,
+		0x2e292020, 0x08220812, 0x41222000, 0x10041450, 0x10f92020, 0x3efa084c, 0x7d22103c, 0x107df7de,
+		0xe8a12020, 0x08220832, 0x05220800, 0x10450410, 0xa4a3f000, 0x08520832, 0x05220400, 0x10450410,
+		0xe2f92020, 0x0002085e, 0x7d3e0281, 0x107df41f, 0x00200000, 0x8001b000, 0x00000000, 0x00000000,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xc0000fbe, 0xfbf7e00f, 0x5fbf7e7d, 0x0050bee8,
+		0x440808a2, 0x0a142fe8, 0x50810285, 0x0050a048, 0x49e428a2, 0x0a142828, 0x40810284, 0x0048a048,
+		0x10020fbe, 0x09f7ebaf, 0xd89f3e84, 0x0047a04f, 0x09e48822, 0x0a142aa1, 0x50810284, 0x0048a048,
+		0x04082822, 0x0a142fa0, 0x50810285, 0x0050a248, 0x00008fbe, 0xfbf42021, 0x5f817e7d, 0x07d09ce8,
+		0x00008000, 0x00000fe0, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x000c0180,
+		0xdfbf4282, 0x0bfbf7ef, 0x42850505, 0x004804bf, 0x50a142c6, 0x08401428, 0x42852505, 0x00a808a0,
+		0x50a146aa, 0x08401428, 0x42852505, 0x00081090, 0x5fa14a92, 0x0843f7e8, 0x7e792505, 0x00082088,
+		0x40a15282, 0x08420128, 0x40852489, 0x00084084, 0x40a16282, 0x0842022a, 0x40852451, 0x00088082,
+		0xc0bf4282, 0xf843f42f, 0x7e85fc21, 0x3e0900bf, 0x00000000, 0x00000004, 0x00000000, 0x000c0180,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x04000402, 0x41482000, 0x00000000, 0x00000800,
+		0x04000404, 0x4100203c, 0x00000000, 0x00000800, 0xf7df7df0, 0x514bef85, 0xbefbefbe, 0x04513bef,
+		0x14414500, 0x494a2885, 0xa28a28aa, 0x04510820, 0xf44145f0, 0x474a289d, 0xa28a28aa, 0x04510be0,
+		0x14414510, 0x494a2884, 0xa28a28aa, 0x02910a00, 0xf7df7df0, 0xd14a2f85, 0xbefbe8aa, 0x011f7be0,
+		0x00000000, 0x00400804, 0x20080000, 0x00000000, 0x00000000, 0x00600f84, 0x20080000, 0x00000000,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xac000000, 0x00000f01, 0x00000000, 0x00000000,
+		0x24000000, 0x00000f01, 0x00000000, 0x06000000, 0x24000000, 0x00000f01, 0x00000000, 0x09108000,
+		0x24fa28a2, 0x00000f01, 0x00000000, 0x013e0000, 0x2242252a, 0x00000f52, 0x00000000, 0x038a8000,
+		0x2422222a, 0x00000f29, 0x00000000, 0x010a8000, 0x2412252a, 0x00000f01, 0x00000000, 0x010a8000,
+		0x24fbe8be, 0x00000f01, 0x00000000, 0x0ebe8000, 0xac020000, 0x00000f01, 0x00000000, 0x00048000,
+		0x0003e000, 0x00000f00, 0x00000000, 0x00008000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		0x00000000, 0x00000038, 0x8443b80e, 0x00203a03, 0x02bea080, 0xf0000020, 0xc452208a, 0x04202b02,
+		0xf8029122, 0x07f0003b, 0xe44b388e, 0x02203a02, 0x081e8a1c, 0x0411e92a, 0xf4420be0, 0x01248202,
+		0xe8140414, 0x05d104ba, 0xe7c3b880, 0x00893a0a, 0x283c0e1c, 0x04500902, 0xc4400080, 0x00448002,
+		0xe8208422, 0x04500002, 0x80400000, 0x05200002, 0x083e8e00, 0x04100002, 0x804003e0, 0x07000042,
+		0xf8008400, 0x07f00003, 0x80400000, 0x04000022, 0x00000000, 0x00000000, 0x80400000, 0x04000002,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00800702, 0x1848a0c2, 0x84010000, 0x02920921,
+		0x01042642, 0x00005121, 0x42023f7f, 0x00291002, 0xefc01422, 0x7efdfbf7, 0xefdfa109, 0x03bbbbf7,
+		0x28440f12, 0x42850a14, 0x20408109, 0x01111010, 0x28440408, 0x42850a14, 0x2040817f, 0x01111010,
+		0xefc78204, 0x7efdfbf7, 0xe7cf8109, 0x011111f3, 0x2850a932, 0x42850a14, 0x2040a109, 0x01111010,
+		0x2850b840, 0x42850a14, 0xefdfbf79, 0x03bbbbf7, 0x001fa020, 0x00000000, 0x00001000, 0x00000000,
+		0x00002070, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		0x08022800, 0x00012283, 0x02430802, 0x01010001, 0x8404147c, 0x20000144, 0x80048404, 0x00823f08,
+		0xdfbf4284, 0x7e03f7ef, 0x142850a1, 0x0000210a, 0x50a14684, 0x528a1428, 0x142850a1, 0x03efa17a,
+		0x50a14a9e, 0x52521428, 0x142850a1, 0x02081f4a, 0x50a15284, 0x4a221428, 0xf42850a1, 0x03efa14b,
+		0x50a16284, 0x4a521428, 0x042850a1, 0x0228a17a, 0xdfbf427c, 0x7e8bf7ef, 0xf7efdfbf, 0x03efbd0b,
+		0x00000000, 0x04000000, 0x00000000, 0x00000008, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00200508, 0x00840400, 0x11458122, 0x00014210,
+		0x00514294, 0x51420800, 0x20a22a94, 0x0050a508, 0x00200000, 0x00000000, 0x00050000, 0x08000000,
+		0xfefbefbe, 0xfbefbefb, 0xfbeb9114, 0x00fbefbe, 0x20820820, 0x8a28a20a, 0x8a289114, 0x3e8a28a2,
+		0xfefbefbe, 0xfbefbe0b, 0x8a289114, 0x008a28a2, 0x228a28a2, 0x08208208, 0x8a289114, 0x088a28a2,
+		0xfefbefbe, 0xfbefbefb, 0xfa2f9114, 0x00fbefbe, 0x00000000, 0x00000040, 0x00000000, 0x00000000,
+		0x00000000, 0x00000020, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+		0x00210100, 0x00000004, 0x00000000, 0x00000000, 0x14508200, 0x00001402, 0x00000000, 0x00000000,
+		0x00000010, 0x00000020, 0x00000000, 0x00000000, 0xa28a28be, 0x00002228, 0x00000000, 0x00000000,
+		0xa28a28aa, 0x000022e8, 0x00000000, 0x00000000, 0xa28a28aa, 0x000022a8, 0x00000000, 0x00000000,
+		0xa28a28aa, 0x000022e8, 0x00000000, 0x00000000, 0xbefbefbe, 0x00003e2f, 0x00000000, 0x00000000,
+		0x00000004, 0x00002028, 0x00000000, 0x00000000, 0x80000000, 0x00003e0f,
+	};
+
+	inline constexpr uint8_t WIDTHS[224] = {
+		3, 1, 4, 6, 5, 7, 6, 2, 3, 3, 5, 5, 2, 4, 1, 7, 5, 2, 5, 5, 5, 5, 5, 5, 5, 5, 1, 1, 3, 4, 3, 6,
+		7, 6, 6, 6, 6, 6, 6, 6, 6, 3, 5, 6, 5, 7, 6, 6, 6, 6, 6, 6, 7, 6, 7, 7, 6, 6, 6, 2, 7, 2, 3, 5,
+		2, 5, 5, 5, 5, 5, 4, 5, 5, 1, 2, 5, 2, 5, 5, 5, 5, 5, 5, 5, 4, 5, 5, 5, 5, 5, 5, 3, 1, 3, 4, 4,
+		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+		1, 1, 5, 5, 5, 7, 1, 5, 3, 7, 3, 5, 4, 1, 7, 4, 3, 5, 3, 3, 2, 5, 6, 1, 2, 2, 3, 5, 6, 6, 6, 6,
+		6, 6, 6, 6, 6, 6, 7, 6, 6, 6, 6, 6, 3, 3, 3, 3, 7, 6, 6, 6, 6, 6, 6, 5, 6, 6, 6, 6, 6, 6, 4, 6,
+		5, 5, 5, 5, 5, 5, 9, 5, 5, 5, 5, 5, 2, 2, 3, 3, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 5,
+	};
+}
+
+inline void SoftRaster::BuildFont() {
+	static constexpr int SIZE = 128;
+	static constexpr int GAP = 1; // between glyphs, both ways
+	Level& atlas = font.levels.emplace_back();
+	atlas.w = SIZE;
+	atlas.h = SIZE;
+	atlas.texels.assign(SIZE * SIZE, 0);
+	for (size_t i = 0; i < atlas.texels.size(); ++i) {
+		size_t word = i / 32;
+		if (word < std::size(SoftFont::BITS) && ((SoftFont::BITS[word] >> (i % 32)) & 1)) atlas.texels[i] = 0xFFFFFFFFu;
+	}
+
+	// Laid out left to right in rows, as LoadFontDefault() finds them
+	int line = 0;
+	int x = GAP;
+	int next = GAP;
+	for (int i = 0; i < 224; ++i) {
+		float w = SoftFont::WIDTHS[i];
+		glyphs[i] = { static_cast<float>(x), static_cast<float>(GAP + line * (FONT_HEIGHT + GAP)), w, static_cast<float>(FONT_HEIGHT) };
+		next += SoftFont::WIDTHS[i] + GAP;
+		if (next >= SIZE) {
+			line++;
+			x = 2 * GAP + SoftFont::WIDTHS[i];
+			next = x;
+			glyphs[i].x = static_cast<float>(GAP);
+			glyphs[i].y = static_cast<float>(GAP + line * (FONT_HEIGHT + GAP));
+		}
+		else x = next;
+	}
+}
@@ -0,0 +1,229 @@
+// Renders a fixed scene with the CPU rasterizer: no window, no GPU. The scene is drawn
+// with the game's own draw functions (sector grid, hearts, shots, asteroids, swarm,
+// player, HUD) through Renderer and RenderQueue into SoftRaster, so changes to the draw
+// path can be measured on machines without a GPU and checked against reference images.
+// The player wears its nightmare sprite, the one the repository ships.
+//
+//   SoftRender [--frames n] [--asteroids n] [--shots n] [--enemies n] [--seed n] [--unsorted]
+//              [--png out.png] [--golden reference.png] [--tolerance n] [--max-diff n]
+//
+// Prints calls, primitives, pixels and time per primitive type, per frame. --png writes
+// the last frame. --golden compares the last frame with a reference written by --png
+// earlier and exits with 1 if more than --max-diff pixels are off by more than
+// --tolerance in a channel. AVX2 and scalar builds draw the same image, but fused
+// multiply-adds and -ffast-math both move a few edge pixels, so a reference only holds
+// for the floating-point flags it was written with. softrender.sh checks
+// source/softrender_reference.png with bench.sh's flags and contraction off. Writing or
+// comparing an image needs the game's PNGs in the working directory.
+
+#define _CRT_SECURE_NO_WARNINGS
+#define UNICORNS_NO_MAIN
+#include "Main.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace SoftRender {
+	static constexpr int SCREEN_W = 1200;
+	static constexpr int SCREEN_H = 1200;
+	static constexpr float SECTOR = 1200.f;
+	static constexpr int SECTORS = 3; // the scene sits in the middle one, clear of the world's edge
+	static constexpr float DT = 1.f / 60.f;
+
+	// Files the scene draws
+	static const char* const SPRITES[] = { "cake.png", Weapon(WeaponType::BULLET).sprite, "unicorn_nightmare.png" };
+
+	using Clock = std::chrono::steady_clock;
+
+	static Vector2 RandomIn(Rectangle r) {
+		return { Utils::RandomFloat(r.x, r.x + r.width), Utils::RandomFloat(r.y, r.y + r.height) };
+	}
+
+	// Pixels of 'image' further than 'tolerance' from the framebuffer in any channel, -1
+	// if the sizes differ
+	static int CountDiffs(const Image& image, const SoftRaster& raster, int tolerance, int& largest) {
+		largest = 0;
+		if (image.width != raster.Width() || image.height != raster.Height()) return -1;
+		const uint32_t* a = static_cast<const uint32_t*>(image.data);
+		const uint32_t* b = raster.Pixels();
+		int count = 0;
+		for (int i = 0; i < image.width * image.height; ++i) {
+			int worst = 0;
+			for (int sh = 0; sh < 24; sh += 8) {
+				worst = std::max(worst, abs(static_cast<int>((a[i] >> sh) & 0xFF) - static_cast<int>((b[i] >> sh) & 0xFF)));
+			}
+			largest = std::max(largest, worst);
+			if (worst > tolerance) count++;
+		}
+		return count;
+	}
+}
+
+int main(int argc, char** argv) {
+	using namespace SoftRender;
+	int frames = 120;
+	int asteroidCount = 300;
+	int shotCount = 400;
+	int enemyCount = 200;
+	uint64_t seed = 1;
+	bool sorted = true;
+	const char* pngPath = nullptr;
+	const char* goldenPath = nullptr;
+	int tolerance = 0;
+	int maxDiff = 0;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = std::max(atoi(argv[++i]), 1);
+		else if (!strcmp(argv[i], "--asteroids") && i + 1 < argc) asteroidCount = std::max(atoi(argv[++i]), 0);
+		else if (!strcmp(argv[i], "--shots") && i + 1 < argc) shotCount = std::max(atoi(argv[++i]), 0);
+		else if (!strcmp(argv[i], "--enemies") && i + 1 < argc) enemyCount = std::max(atoi(argv[++i]), 0);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "--unsorted")) sorted = false;
+		else if (!strcmp(argv[i], "--png") && i + 1 < argc) pngPath = argv[++i];
+		else if (!strcmp(argv[i], "--golden") && i + 1 < argc) goldenPath = argv[++i];
+		else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--max-diff") && i + 1 < argc) maxDiff = atoi(argv[++i]);
+	}
+	SetTraceLogLevel(LOG_WARNING);
+
+	Renderer& renderer = Renderer::Instance();
+	renderer.InitSoftware(SCREEN_W, SCREEN_H);
+	SoftRaster& raster = renderer.Software();
+	RenderQueue& queue = renderer.Queue();
+	queue.SetSorting(sorted);
+	Utils::Rng().Seed(seed);
+
+	bool missing = false;
+	for (const char* path : SPRITES) {
+		if (FileExists(path)) continue;
+		printf("%s not found, drawn without it\n", path);
+		missing = true;
+	}
+	if (missing && (pngPath || goldenPath)) {
+		printf("images need every sprite, run from the directory with the game's PNGs\n");
+		return 1;
+	}
+	ShotSprites::Load();
+	Heart::LoadAssets();
+	PlayerShip player(SCREEN_W, SCREEN_H);
+	player.EnableNightmareMode();
+
+	// The world a bit larger than the screen, so the camera pan keeps everything in view
+	Rectangle world = { SECTOR - SCREEN_W * 0.25f, SECTOR - SCREEN_H * 0.25f, SCREEN_W * 1.5f, SCREEN_H * 1.5f };
+	std::vector<std::unique_ptr<Asteroid>> asteroids;
+	for (int i = 0; i < asteroidCount; ++i) {
+		std::unique_ptr<Asteroid> a = MakeAsteroid(SCREEN_W, SCREEN_H, AsteroidShape::RANDOM, i % 2 == 1);
+		a->MoveBy(Vector2Subtract(RandomIn(world), a->GetPosition()));
+		asteroids.push_back(std::move(a));
+	}
+	std::vector<Shot> lasers, bullets;
+	for (int i = 0; i < shotCount; ++i) {
+		std::vector<Shot>& shots = i % 2 ? bullets : lasers;
+		float speed = Weapon(i % 2 ? WeaponType::BULLET : WeaponType::LASER).Speed();
+		shots.push_back({ RandomIn(world), { 0.f, -speed }, 0 });
+	}
+	std::vector<EnemyShip> enemies;
+	for (int i = 0; i < enemyCount; ++i) {
+		float angle = Utils::RandomFloat(0, 2 * PI);
+		enemies.emplace_back(RandomIn(world), Vector2{ cosf(angle) * 150.f, sinf(angle) * 150.f }, 0u, i % 4 == 0);
+	}
+	std::vector<Heart> hearts;
+	for (int i = 0; i < 6; ++i) {
+		Heart& h = hearts.emplace_back(SCREEN_W, SCREEN_H);
+		h.MoveBy(Vector2Subtract(RandomIn(world), h.GetPosition()));
+	}
+
+	std::vector<double> frameMs;
+	for (int f = 0; f < frames; ++f) {
+		for (auto& a : asteroids) a->Update(DT);
+		for (Shot& s : lasers) s.position.y = s.position.y < world.y ? world.y + world.height : s.position.y + s.velocity.y * DT;
+		for (Shot& s : bullets) s.position.y = s.position.y < world.y ? world.y + world.height : s.position.y + s.velocity.y * DT;
+		for (EnemyShip& e : enemies) e.Update(DT);
+
+		Clock::time_point t0 = Clock::now();
+		float time = f * DT;
+		FrameOverlay overlay;
+		overlay.time = time;
+		overlay.flash = f % 60 < 10 ? 0.3f : 0.f;
+		renderer.Begin(overlay);
+
+		Camera2D camera{};
+		camera.offset = { SCREEN_W * 0.5f, SCREEN_H * 0.5f };
+		camera.target = { SECTOR + SCREEN_W * 0.5f + 150.f * sinf(time), SECTOR + SCREEN_H * 0.5f + 100.f * cosf(time) };
+		camera.zoom = 1.f;
+		Rectangle view = { camera.target.x - camera.offset.x, camera.target.y - camera.offset.y, (float)SCREEN_W, (float)SCREEN_H };
+		renderer.BeginWorld(camera);
+		DrawSectorGrid(view, SECTOR, SECTORS, SECTORS);
+		queue.SetLayer(RenderLayer::WORLD);
+		DrawHearts(hearts, view, false);
+		DrawShots<WeaponType::LASER>(lasers, view, false, time);
+		DrawShots<WeaponType::BULLET>(bullets, view, false, time);
+		for (const auto& a : asteroids) {
+			if (Utils::Overlaps(a->GetPosition(), a->GetRadius(), view)) a->Draw();
+		}
+		for (const EnemyShip& e : enemies) {
+			if (Utils::Overlaps(e.GetPosition(), e.GetRadius(), view)) e.Draw();
+		}
+		queue.SetLayer(RenderLayer::PLAYER);
+		player.MoveBy(Vector2Subtract(camera.target, player.GetPosition()));
+		player.Draw();
+		renderer.EndWorld();
+		renderer.Composite();
+
+		HudState hud;
+		hud.score = f * 10;
+		hud.boostCharge = (f % 100) / 100.f;
+		hud.boostReady = f % 100 == 99;
+		hud.time = time;
+		DrawHud(hud);
+		renderer.End();
+		frameMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+	}
+
+	SoftRaster::Stats stats = raster.TakeStats();
+	const Renderer::FrameStats& last = renderer.LastFrame();
+	printf("%dx%d, %d frames, %d workers, %d px tiles, queue %s, %zu commands in the last frame\n", SCREEN_W, SCREEN_H, frames,
+		JobPool::Instance().Workers(), SoftRaster::TILE, sorted ? "sorted" : "unsorted", last.commands);
+	printf("%-10s %10s %12s %12s %10s %10s\n", "per frame", "calls", "primitives", "pixels", "ms", "ns/pixel");
+	for (int k = 0; k < SOFT_PRIMITIVES; ++k) {
+		const SoftRaster::PrimitiveStats& p = stats.primitive[k];
+		printf("%-10s %10.1f %12.1f %12.0f %10.3f %10.2f\n", SoftPrimitiveName(static_cast<SoftPrimitive>(k)),
+			p.calls / (double)frames, p.primitives / (double)frames, p.pixels / (double)frames, p.ms / frames,
+			p.pixels ? p.ms * 1e6 / p.pixels : 0.0);
+	}
+	std::vector<double> sortedMs = frameMs;
+	std::sort(sortedMs.begin(), sortedMs.end());
+	double total = 0.0;
+	for (double ms : frameMs) total += ms;
+	printf("binning %.3f ms, rasterizing %.3f ms per frame; frame p50 %.3f ms, mean %.3f ms, max %.3f ms\n",
+		stats.binMs / frames, stats.rasterMs / frames, sortedMs[sortedMs.size() / 2], total / frames, sortedMs.back());
+	if (stats.missingTextures) printf("%llu draws of textures never added\n", (unsigned long long)stats.missingTextures);
+
+	if (pngPath) {
+		if (!raster.ExportPng(pngPath)) {
+			printf("could not write %s\n", pngPath);
+			return 1;
+		}
+		printf("last frame written to %s\n", pngPath);
+	}
+	if (goldenPath) {
+		Image golden = LoadImage(goldenPath);
+		if (!golden.data) {
+			printf("could not read %s\n", goldenPath);
+			return 1;
+		}
+		ImageFormat(&golden, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+		int largest = 0;
+		int diffs = CountDiffs(golden, raster, tolerance, largest);
+		UnloadImage(golden);
+		if (diffs < 0) {
+			printf("golden: %s is not %dx%d\n", goldenPath, SCREEN_W, SCREEN_H);
+			return 1;
+		}
+		printf("golden: %d pixels off by more than %d (largest difference %d), %s\n", diffs, tolerance, largest,
+			diffs > maxDiff ? "FAILED" : "ok");
+		if (diffs > maxDiff) return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <raylib.h>
+#include <raymath.h>
+
+// --- SWARMS ---
+// Flocking (separation, alignment, cohesion) plus a seek towards a target. Agents are
+// indexed in a spatial hash rebuilt once per tick: a counting sort of agents by cell into
+// packed x / y / vx / vy arrays, so the neighbours of a cell are one contiguous run that
+// Query() sums 8 lanes at a time. Neighbours are everything within 'neighbourRadius'
+// rather than the k nearest: in a dense swarm that is the same set, without a sort.
+
+struct FlockParams {
+	float neighbourRadius = 60.f;  // also the cell size
+	float separationRadius = 24.f;
+	float maxSpeed = 180.f;
+	float maxForce = 360.f;        // px/s^2
+	float separation = 1.8f;
+	float alignment = 1.0f;
+	float cohesion = 0.8f;
+	float seek = 1.2f;
+};
+
+// What an agent sees of its neighbours
+struct FlockSums {
+	int count = 0;
+	float x = 0.f;    // positions, for cohesion
+	float y = 0.f;
+	float vx = 0.f;   // velocities, for alignment
+	float vy = 0.f;
+	float sepX = 0.f; // sum of -offset / distance^2 within separationRadius
+	float sepY = 0.f;
+};
+
+class FlockIndex {
+public:
+	static constexpr uint32_t MIN_BUCKETS = 1024;
+
+	// get(i, position, velocity) fills agent i
+	template<typename Get>
+	void Build(size_t count, float cellSize, Get&& get) {
+		cell = cellSize;
+		invCell = 1.f / cellSize;
+		uint32_t buckets = MIN_BUCKETS;
+		while (buckets < count * 2) buckets *= 2;
+		mask = buckets - 1;
+		start.assign(buckets + 1, 0);
+
+		scratch.resize(count);
+		bucketOf.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			Agent& a = scratch[i];
+			get(i, a.position, a.velocity);
+			bucketOf[i] = Bucket(CellOf(a.position.x), CellOf(a.position.y));
+			start[bucketOf[i] + 1]++;
+		}
+		for (uint32_t b = 0; b < buckets; ++b) start[b + 1] += start[b];
+
+		// Packed in bucket order, padded so the vector loop can always load whole lanes
+		size_t padded = count + LANES;
+		x.resize(padded);
+		y.resize(padded);
+		vx.resize(padded);
+		vy.resize(padded);
+		ids.resize(count);
+		fill.assign(start.begin(), start.end() - 1);
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t at = fill[bucketOf[i]]++;
+			x[at] = scratch[i].position.x;
+			y[at] = scratch[i].position.y;
+			vx[at] = scratch[i].velocity.x;
+			vy[at] = scratch[i].velocity.y;
+			ids[at] = static_cast<uint32_t>(i);
+		}
+	}
+
+	size_t Size() const { return ids.size(); }
+
+	// Sums over every agent within 'radius' of p, excluding any at exactly p (itself)
+	FlockSums Query(Vector2 p, float radius, float separationRadius) const {
+		Accumulator acc(p, radius, separationRadius);
+		uint32_t seen[9];
+		int buckets = NearBuckets(p, seen);
+		for (int k = 0; k < buckets; ++k) {
+			acc.Add(*this, start[seen[k]], start[seen[k] + 1]);
+		}
+		return acc.Sums();
+	}
+
+	// fn(id) for every agent within 'radius' of p
+	template<typename Fn>
+	void ForEachNear(Vector2 p, float radius, Fn&& fn) const {
+		if (ids.empty()) return;
+		float r2 = radius * radius;
+		uint32_t seen[9];
+		int buckets = NearBuckets(p, seen);
+		for (int k = 0; k < buckets; ++k) {
+			for (uint32_t j = start[seen[k]]; j < start[seen[k] + 1]; ++j) {
+				float dx = x[j] - p.x;
+				float dy = y[j] - p.y;
+				if (dx * dx + dy * dy < r2) fn(ids[j]);
+			}
+		}
+	}
+
+private:
+	static constexpr uint32_t LANES = 8;
+
+	struct Agent {
+		Vector2 position;
+		Vector2 velocity;
+	};
+
+	int32_t CellOf(float v) const {
+		return static_cast<int32_t>(floorf(v * invCell));
+	}
+
+	uint32_t Bucket(int32_t cx, int32_t cy) const {
+		return (static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u) & mask;
+	}
+
+	// Buckets of the 3x3 cells around p, without duplicates so nothing is counted twice
+	int NearBuckets(Vector2 p, uint32_t (&out)[9]) const {
+		int32_t cx = CellOf(p.x);
+		int32_t cy = CellOf(p.y);
+		int n = 0;
+		for (int32_t dy = -1; dy <= 1; ++dy) {
+			for (int32_t dx = -1; dx <= 1; ++dx) {
+				uint32_t b = Bucket(cx + dx, cy + dy);
+				if (std::find(out, out + n, b) == out + n) out[n++] = b;
+			}
+		}
+		return n;
+	}
+
+#if defined(__AVX2__)
+	class Accumulator {
+	public:
+		Accumulator(Vector2 p, float radius, float separationRadius)
+			: px(_mm256_set1_ps(p.x)), py(_mm256_set1_ps(p.y)),
+			r2(_mm256_set1_ps(radius * radius)), s2(_mm256_set1_ps(separationRadius * separationRadius)) {}
+
+		void Add(const FlockIndex& index, uint32_t begin, uint32_t end) {
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			for (uint32_t j = begin; j < end; j += LANES) {
+				// Lanes past 'end' read the next bucket or the padding and are masked off
+				__m256 valid = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(end - j)), lane));
+				__m256 ox = _mm256_loadu_ps(&index.x[j]);
+				__m256 oy = _mm256_loadu_ps(&index.y[j]);
+				__m256 dx = _mm256_sub_ps(ox, px);
+				__m256 dy = _mm256_sub_ps(oy, py);
+				__m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+				__m256 inside = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(d2, r2, _CMP_LT_OQ), _mm256_cmp_ps(d2, zero, _CMP_GT_OQ)));
+				count += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(inside)));
+				sx = _mm256_add_ps(sx, _mm256_and_ps(inside, ox));
+				sy = _mm256_add_ps(sy, _mm256_and_ps(inside, oy));
+				svx = _mm256_add_ps(svx, _mm256_and_ps(inside, _mm256_loadu_ps(&index.vx[j])));
+				svy = _mm256_add_ps(svy, _mm256_and_ps(inside, _mm256_loadu_ps(&index.vy[j])));
+				__m256 close = _mm256_and_ps(inside, _mm256_cmp_ps(d2, s2, _CMP_LT_OQ));
+				__m256 inv = _mm256_and_ps(close, _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_max_ps(d2, _mm256_set1_ps(1e-6f))));
+				sepX = _mm256_sub_ps(sepX, _mm256_mul_ps(dx, inv));
+				sepY = _mm256_sub_ps(sepY, _mm256_mul_ps(dy, inv));
+			}
+		}
+
+		FlockSums Sums() const {
+			FlockSums s;
+			s.count = count;
+			s.x = Sum(sx);
+			s.y = Sum(sy);
+			s.vx = Sum(svx);
+			s.vy = Sum(svy);
+			s.sepX = Sum(sepX);
+			s.sepY = Sum(sepY);
+			return s;
+		}
+
+	private:
+		static float Sum(__m256 v) {
+			__m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+			h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+			h = _mm_add_ss(h, _mm_shuffle_ps(h, h, 1));
+			return _mm_cvtss_f32(h);
+		}
+
+		__m256 px, py, r2, s2;
+		__m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps();
+		__m256 svx = _mm256_setzero_ps(), svy = _mm256_setzero_ps();
+		__m256 sepX = _mm256_setzero_ps(), sepY = _mm256_setzero_ps();
+		int count = 0;
+	};
+#else
+	class Accumulator {
+	public:
+		Accumulator(Vector2 p, float radius, float separationRadius)
+			: p(p), r2(radius * radius), s2(separationRadius * separationRadius) {}
+
+		void Add(const FlockIndex& index, uint32_t begin, uint32_t end) {
+			for (uint32_t j = begin; j < end; ++j) {
+				float dx = index.x[j] - p.x;
+				float dy = index.y[j] - p.y;
+				float d2 = dx * dx + dy * dy;
+				if (!(d2 < r2) || !(d2 > 0.f)) continue;
+				s.count++;
+				s.x += index.x[j];
+				s.y += index.y[j];
+				s.vx += index.vx[j];
+				s.vy += index.vy[j];
+				if (d2 < s2) {
+					float inv = 1.f / fmaxf(d2, 1e-6f);
+					s.sepX -= dx * inv;
+					s.sepY -= dy * inv;
+				}
+			}
+		}
+
+		FlockSums Sums() const { return s; }
+
+	private:
+		Vector2 p;
+		float r2, s2;
+		FlockSums s;
+	};
+#endif
+
+	float cell = 1.f;
+	float invCell = 1.f;
+	uint32_t mask = 0;
+	std::vector<uint32_t> start; // bucket b is [start[b], start[b + 1])
+	std::vector<uint32_t> fill;
+	std::vector<float> x, y, vx, vy;
+	std::vector<uint32_t> ids;   // packed slot -> agent
+	std::vector<Agent> scratch;
+	std::vector<uint32_t> bucketOf;
+};
+
+// Reynolds steering: each rule asks for a velocity of maxSpeed in its direction and
+// contributes (desired - velocity) limited to maxForce, weighted. Returns px/s^2.
+inline Vector2 FlockSteer(Vector2 position, Vector2 velocity, const FlockSums& s, Vector2 target, const FlockParams& f) {
+	auto rule = [&](Vector2 direction, float weight) {
+		if (direction.x == 0.f && direction.y == 0.f) return Vector2{ 0, 0 };
+		Vector2 desired = Vector2Scale(Vector2Normalize(direction), f.maxSpeed);
+		return Vector2Scale(Vector2ClampValue(Vector2Subtract(desired, velocity), 0.f, f.maxForce), weight);
+	};
+	Vector2 force = rule(Vector2Subtract(target, position), f.seek);
+	if (s.count > 0) {
+		float inv = 1.f / s.count;
+		force = Vector2Add(force, rule({ s.sepX, s.sepY }, f.separation));
+		force = Vector2Add(force, rule({ s.vx * inv, s.vy * inv }, f.alignment));
+		force = Vector2Add(force, rule({ s.x * inv - position.x, s.y * inv - position.y }, f.cohesion));
+	}
+	return force;
+}
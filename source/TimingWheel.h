@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- HIERARCHICAL TIMING WHEEL ---
+// Schedules values for a future tick. Level 0 has one slot per tick; each higher level
+// covers SLOTS times the span of the one below and is cascaded down when the lower
+// level wraps. Schedule and expiry are O(1) amortised per item; ticks with nothing
+// due cost one empty slot check.
+template<typename T>
+class TimingWheel {
+public:
+	static constexpr int BITS = 6;
+	static constexpr int SLOTS = 1 << BITS;
+	static constexpr int LEVELS = 4; // 2^24 ticks ahead, ~77 hours at 60 Hz
+
+	uint32_t Now() const {
+		return now;
+	}
+
+	size_t Size() const {
+		return size;
+	}
+
+	// Items due at or before Now() fire on the next Advance()
+	void Schedule(uint32_t tick, const T& value) {
+		if (tick <= now) tick = now + 1;
+		Place({ tick, value });
+		size++;
+	}
+
+	// Moves time forward to 'tick' and calls fire(value) for every item that became due
+	template<typename Fire>
+	void Advance(uint32_t tick, Fire&& fire) {
+		while (now < tick) {
+			now++;
+			if ((now & (SLOTS - 1)) == 0) Cascade(1);
+			auto& slot = wheels[0][now & (SLOTS - 1)];
+			if (slot.empty()) continue;
+			// fire() may schedule more items, swap out the slot first
+			due.swap(slot);
+			for (const Entry& e : due) {
+				size--;
+				fire(e.value);
+			}
+			due.clear();
+		}
+	}
+
+	// Calls fn(value) for everything still scheduled, in no particular order
+	template<typename Fn>
+	void ForEach(Fn&& fn) const {
+		for (const auto& level : wheels) {
+			for (const auto& slot : level) {
+				for (const Entry& e : slot) fn(e.value);
+			}
+		}
+	}
+
+	void Clear() {
+		for (auto& level : wheels) {
+			for (auto& slot : level) slot.clear();
+		}
+		size = 0;
+	}
+
+	// Restarts the wheel at 'tick', dropping everything scheduled
+	void Reset(uint32_t tick) {
+		Clear();
+		now = tick;
+	}
+
+private:
+	struct Entry {
+		uint32_t tick;
+		T value;
+	};
+
+	void Place(const Entry& e) {
+		uint32_t delta = e.tick - now;
+		int level = 0;
+		while (level < LEVELS - 1 && delta >= (1u << (BITS * (level + 1)))) level++;
+		// Beyond the horizon: park in the last slot of the top level, it gets re-placed on cascade
+		uint32_t slot = delta >= (1u << (BITS * LEVELS)) ? ((now >> (BITS * level)) - 1) : (e.tick >> (BITS * level));
+		wheels[level][slot & (SLOTS - 1)].push_back(e);
+	}
+
+	// Re-places the items of the current slot of 'level' into the lower levels
+	void Cascade(int level) {
+		if (level >= LEVELS) return;
+		uint32_t index = (now >> (BITS * level)) & (SLOTS - 1);
+		if (index == 0) Cascade(level + 1);
+		auto& slot = wheels[level][index];
+		if (slot.empty()) return;
+		moving.swap(slot);
+		for (const Entry& e : moving) Place(e);
+		moving.clear();
+	}
+
+	uint32_t now = 0;
+	size_t size = 0;
+	std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> wheels;
+	std::vector<Entry> due;
+	std::vector<Entry> moving;
+};